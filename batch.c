@@ -0,0 +1,268 @@
+/*
+ * Name: batch.c
+ *
+ * Function: batch mode for the rt2ps and et2ps filters. See batch.h for
+ *	a description. The files are converted by a work-stealing thread
+ *	pool, see pool.h.
+ */
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "batch.h"
+#include "input.h"
+#include "pool.h"
+
+/*
+ * a batch of files
+ */
+struct batch {
+	int dialect;		/* EN_RICHTEXT or EN_ENRICHED */
+	const struct enOptions *opt;	/* conversion options */
+	const char *n;		/* program name, for error messages */
+	char **in;		/* input file names */
+	char **out;		/* output file names */
+	char *failed;		/* flag for each file: conversion failed */
+};
+
+/*
+ * a file, as the file system knows it
+ */
+struct fileId {
+	dev_t dev;		/* device */
+	ino_t ino;		/* and inode number */
+};
+
+/*
+ * where a conversion's PostScript goes
+ */
+struct file {
+	int fd;			/* the output file */
+	int err;		/* errno of the first write error, or 0 */
+};
+
+static char *outName( const char *, const char *, const char * );
+static int   outCompare( const void *, const void * );
+static int   inputCheck( struct batch *, int );
+static int   idCompare( const void *, const void * );
+static void  convert( void *, int );
+static void  fileSink( void *, const char *, size_t );
+
+/*
+ * convert "nfiles" files into directory "dir", using "jobs" threads.
+ * "name" is the program name, for error messages.
+ *
+ * returns 0 if all the files were converted, otherwise 1.
+ */
+int
+batchRun( int dialect, const struct enOptions *opt, int jobs, const char *dir,
+	  char **files, int nfiles, const char *name )
+{
+	struct batch b;
+	char **sorted;
+	const char *suffix;
+	int i;
+	int rc = 0;
+
+	b.dialect = dialect;
+	b.opt = opt;
+	b.n = name;
+	b.in = files;
+	b.out = calloc(nfiles, sizeof(char *));
+	sorted = calloc(nfiles, sizeof(char *));
+	b.failed = calloc(nfiles, 1);
+	if (b.out == NULL || sorted == NULL || b.failed == NULL) {
+		fprintf(stderr, "%s: out of memory\n", name);
+		rc = 1;
+	}
+	suffix = opt->pdf ? ".pdf" : ".ps";
+	for (i = 0; rc == 0 && i < nfiles; i++)
+		if ((sorted[i] = b.out[i] = outName(dir, files[i], suffix)) == NULL) {
+			fprintf(stderr, "%s: out of memory\n", name);
+			rc = 1;
+		}
+
+	/*
+	 * two inputs with the same name, in different directories, would
+	 * overwrite each other's output
+	 */
+	if (rc == 0) {
+		qsort(sorted, nfiles, sizeof(char *), outCompare);
+		for (i = 1; i < nfiles; i++)
+			if (strcmp(sorted[i-1], sorted[i]) == 0) {
+				fprintf(stderr, "%s: more than one input would be written to %s\n",
+					name, sorted[i]);
+				rc = 1;
+			}
+	}
+	if (rc == 0)
+		rc = inputCheck(&b, nfiles);
+
+	if (rc == 0) {
+		poolRun(jobs, nfiles, convert, &b);
+		for (i = 0; i < nfiles; i++)
+			if (b.failed[i])
+				rc = 1;
+	}
+	if (b.out != NULL)
+		for (i = 0; i < nfiles; i++)
+			free(b.out[i]);
+	free(b.out);
+	free(sorted);
+	free(b.failed);
+	return(rc);
+}
+/*
+ * an output which is one of the inputs, e.g. a .ps file in the output
+ * directory, would be truncated before it was read. the files are
+ * compared by device and inode, so that other names for the same file
+ * are caught as well. returns 0, or 1 if there is such an output.
+ */
+static int
+inputCheck( struct batch *b, int nfiles )
+{
+	struct fileId *id;
+	struct fileId key;
+	struct stat st;
+	int n = 0;
+	int i;
+	int rc = 0;
+
+	if ((id = calloc(nfiles, sizeof(*id))) == NULL) {
+		fprintf(stderr, "%s: out of memory\n", b->n);
+		return(1);
+	}
+
+	/*
+	 * an input which can't be found is reported when it's converted
+	 */
+	for (i = 0; i < nfiles; i++)
+		if (stat(b->in[i], &st) == 0) {
+			id[n].dev = st.st_dev;
+			id[n].ino = st.st_ino;
+			n++;
+		}
+	qsort(id, n, sizeof(*id), idCompare);
+	for (i = 0; i < nfiles; i++) {
+		if (stat(b->out[i], &st) != 0)
+			continue;
+		key.dev = st.st_dev;
+		key.ino = st.st_ino;
+		if (bsearch(&key, id, n, sizeof(*id), idCompare) != NULL) {
+			fprintf(stderr, "%s: %s is one of the inputs\n",
+				b->n, b->out[i]);
+			rc = 1;
+		}
+	}
+	free(id);
+	return(rc);
+}
+static int
+idCompare( const void *a, const void *b )
+{
+	const struct fileId *x = a;
+	const struct fileId *y = b;
+
+	if (x->dev != y->dev)
+		return(x->dev < y->dev ? -1 : 1);
+	if (x->ino != y->ino)
+		return(x->ino < y->ino ? -1 : 1);
+	return(0);
+}
+/*
+ * the output file name for input file "in": the last part of the name,
+ * with its suffix replaced by "suffix", in directory "dir"
+ */
+static char *
+outName( const char *dir, const char *in, const char *suffix )
+{
+	const char *base;
+	const char *dot;
+	char *n;
+	size_t len;
+
+	base = strrchr(in, '/');
+	base = (base == NULL) ? in : base + 1;
+	dot = strrchr(base, '.');
+	if (dot == NULL || dot == base)
+		dot = base + strlen(base);
+	len = strlen(dir) + 1 + (size_t)(dot - base) + strlen(suffix);
+	if ((n = malloc(len + 1)) == NULL)
+		return(NULL);
+	sprintf(n, "%s/%.*s%s", dir, (int)(dot - base), base, suffix);
+	return(n);
+}
+static int
+outCompare( const void *a, const void *b )
+{
+	return(strcmp(*(char * const *) a, *(char * const *) b));
+}
+/*
+ * pool task: convert file "k"
+ */
+static void
+convert( void *arg, int k )
+{
+	struct batch *b = arg;
+	struct input in;
+	struct file out;
+	ENCTX *ctx;
+	int fd;
+
+	b->failed[k] = 1;
+	if ((fd = open(b->in[k], O_RDONLY)) < 0 || inOpen(&in, fd) != 0) {
+		fprintf(stderr, "%s: %s: %s\n", b->n, b->in[k], strerror(errno));
+		if (fd >= 0)
+			close(fd);
+		return;
+	}
+	if ((out.fd = open(b->out[k], O_WRONLY | O_CREAT | O_TRUNC, 0666)) < 0) {
+		fprintf(stderr, "%s: %s: %s\n", b->n, b->out[k], strerror(errno));
+		inClose(&in);
+		close(fd);
+		return;
+	}
+	out.err = 0;
+	if ((ctx = enOpen(b->dialect, b->opt, fileSink, &out)) == NULL)
+		fprintf(stderr, "%s: %s: out of memory\n", b->n, b->in[k]);
+	else {
+		if (enFeed(ctx, in.cur, (size_t)(in.end - in.cur)) != 0 ||
+		    enFinish(ctx) != 0)
+			fprintf(stderr, "%s: %s: conversion failed\n", b->n, b->in[k]);
+		else if (out.err != 0)
+			fprintf(stderr, "%s: %s: %s\n", b->n, b->out[k], strerror(out.err));
+		else
+			b->failed[k] = 0;
+		enClose(ctx);
+	}
+	if (close(out.fd) != 0 && !b->failed[k]) {
+		fprintf(stderr, "%s: %s: %s\n", b->n, b->out[k], strerror(errno));
+		b->failed[k] = 1;
+	}
+	inClose(&in);
+	close(fd);
+}
+/*
+ * libenriched sink which writes to an output file, and remembers the
+ * first write error
+ */
+static void
+fileSink( void *arg, const char *s, size_t len )
+{
+	struct file *f = arg;
+	ssize_t n;
+
+	while (len > 0 && f->err == 0) {
+		if ((n = write(f->fd, s, len)) < 0) {
+			if (errno != EINTR)
+				f->err = errno;
+			continue;
+		}
+		s += n;
+		len -= (size_t) n;
+	}
+}
@@ -0,0 +1,22 @@
+/*
+ * Name: batch.h
+ *
+ * Function: batch mode for the rt2ps and et2ps filters, converting the
+ *	files named on the command line into an output directory, several
+ *	at a time.
+ *
+ *	Each input file is written to the output directory under its own
+ *	name, with its suffix (if any) replaced by ".ps", e.g. msg.et is
+ *	converted to outdir/msg.ps. Every conversion has its own
+ *	libenriched context, so the output is the same as converting the
+ *	file on its own. Nothing is converted if an output would overwrite
+ *	one of the inputs, or another input's output.
+ */
+#ifndef BATCH_H
+#define BATCH_H
+
+#include "enriched.h"
+
+int batchRun( int, const struct enOptions *, int, const char *, char **, int, const char * );
+
+#endif /* BATCH_H */
@@ -0,0 +1,340 @@
+/*
+ * Name: charset.c
+ *
+ * Function: libenriched character set conversion, the -C flag of rt2ps
+ *	and et2ps.
+ *
+ *	The prolog reencodes the fonts to ISOLatin1Encoding, and the
+ *	converter copies the bytes of the input into the PostScript
+ *	strings as they are, so anything but ISO-8859-1 (or plain ASCII)
+ *	comes out as the wrong characters. With -C, the input is converted
+ *	to ISO-8859-1 on its way into the converter: from UTF-8, from the
+ *	ISO-8859 sets and from windows-1252 (see mkcharset for the list).
+ *	A character with no ISO-8859-1 code is printed as near as the
+ *	fonts allow: the letters of Latin Extended-A without their accents,
+ *	the quotes as the quoteleft and quoteright ISOLatin1Encoding has in
+ *	place of ` and ', the dashes as hyphens, and so on; anything else
+ *	as "?". A combining accent is left out, leaving the letter before
+ *	it.
+ *
+ *	All these sets are ASCII from 0 to 127, and most mail is mostly
+ *	ASCII, so the input is scanned for the next byte above 127 16 bytes
+ *	at a time (32 when compiled for AVX2), and a long enough run of
+ *	ASCII goes to the converter straight from the caller's block. The
+ *	rest is converted into a buffer, short runs of ASCII and all.
+ *
+ *	A UTF-8 character may be split across blocks; its first bytes are
+ *	kept in the context until the rest arrive. Bytes which aren't UTF-8
+ *	where UTF-8 was expected are taken as windows-1252, which is what
+ *	they usually are.
+ *
+ * Data Format: see engine.c.
+ */
+#include <string.h>
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+#include "enpriv.h"
+#include "charset.h"
+
+/* the charset option values, after 0 for ISO-8859-1 */
+#define CS_UTF8 1
+#define CS_MAP 2		/* and up: csMap[charset - CS_MAP] */
+
+#define CSBUF 4096		/* converted input is collected here */
+#define CSRUN 64		/* a run of ASCII this long isn't copied */
+#define CSMAX 16		/* most bytes one input byte can turn into */
+
+/*
+ * Latin Extended-A, U+0100 to U+017F, as ISO-8859-1: the letter without
+ * its accent, or the ISO-8859-1 letter with the nearest one. a space is
+ * one of the ligatures, see csPut().
+ */
+static const char latinA[128] =
+	"AaAaAaCcCcCcCcDd" "\320dEeEeEeEeEeGgGg"
+	"GgGgHhHhIiIiIiIi" "I\220  JjKkkLlLlLlL"
+	"lLlNnNnNnnNnOoOo" "\326\366  RrRrRrSsSsSs"
+	"SsTtTtTtUuUuUuUu" "\334\374UuWwYyYZzZzZzs";
+
+/*
+ * the other characters which have something near them in ISO-8859-1 or
+ * ISOLatin1Encoding (the accents from 0220 to 0237), sorted by code. an
+ * empty string leaves the character out.
+ */
+static const struct {
+	unsigned short u;
+	const char *s;
+} csSubst[] = {
+	{ 0x0192, "f" },	{ 0x02bc, "'" },	{ 0x02c6, "\223" },
+	{ 0x02c7, "\237" },	{ 0x02d8, "\226" },	{ 0x02d9, "\227" },
+	{ 0x02da, "\232" },	{ 0x02db, "\236" },	{ 0x02dc, "\224" },
+	{ 0x02dd, "\235" },	{ 0x2002, " " },	{ 0x2003, " " },
+	{ 0x2004, " " },	{ 0x2005, " " },	{ 0x2006, " " },
+	{ 0x2007, " " },	{ 0x2008, " " },	{ 0x2009, " " },
+	{ 0x200a, " " },	{ 0x200b, "" },		{ 0x200c, "" },
+	{ 0x200d, "" },		{ 0x2010, "-" },	{ 0x2011, "-" },
+	{ 0x2012, "-" },	{ 0x2013, "-" },	{ 0x2014, "--" },
+	{ 0x2015, "--" },	{ 0x2018, "`" },	{ 0x2019, "'" },
+	{ 0x201a, "," },	{ 0x201b, "`" },	{ 0x201c, "\"" },
+	{ 0x201d, "\"" },	{ 0x201e, "\"" },	{ 0x2020, "+" },
+	{ 0x2021, "+" },	{ 0x2022, "\267" },	{ 0x2026, "..." },
+	{ 0x2030, "%o" },	{ 0x2032, "'" },	{ 0x2033, "\"" },
+	{ 0x2039, "\253" },	{ 0x203a, "\273" },	{ 0x2044, "/" },
+	{ 0x2060, "" },		{ 0x20ac, "EUR" },	{ 0x2122, "TM" },
+	{ 0x2212, "-" },	{ 0xfeff, "" },
+};
+
+static size_t csAscii( const unsigned char *, size_t );
+static int    csByte( ENCTX *, int, char * );
+static int    csBad( ENCTX *, char * );
+static int    csPut( unsigned long, char * );
+
+/*
+ * set opt->charset from a character set name as in a MIME charset
+ * parameter, e.g. "UTF-8" or "iso-8859-15". case, "-" and "_" don't
+ * matter, so "utf8" and "ISO_8859-15" will do too.
+ *
+ * returns 0, or -1 if the character set isn't one of these.
+ */
+int
+enCharset( const char *name, struct enOptions *opt )
+{
+	char a[32], b[32];
+	const char *s;
+	size_t n;
+	int i;
+
+	for (n = 0, s = name; *s && n < sizeof(a) - 1; s++)
+		if (*s != '-' && *s != '_')
+			a[n++] = (char)(*s >= 'A' && *s <= 'Z' ? *s - 'A' + 'a' : *s);
+	a[n] = 0;
+	if (*s != 0)
+		return(-1);
+	if (strcmp(a, "iso88591") == 0 || strcmp(a, "latin1") == 0 ||
+	    strcmp(a, "usascii") == 0 || strcmp(a, "ascii") == 0) {
+		opt->charset = 0;
+		return(0);
+	}
+	if (strcmp(a, "utf8") == 0) {
+		opt->charset = CS_UTF8;
+		return(0);
+	}
+	if (strcmp(a, "cp1252") == 0)
+		strcpy(a, "windows1252");
+	for (i = 0; i < CSCOUNT; i++) {
+		for (n = 0, s = csName[i]; *s; s++)
+			if (*s != '-')
+				b[n++] = *s;
+		b[n] = 0;
+		if (strcmp(a, b) == 0) {
+			opt->charset = CS_MAP + i;
+			return(0);
+		}
+	}
+	return(-1);
+}
+/*
+ * convert a block of input, and pass it on to the converter
+ */
+int
+csFeed( ENCTX *g, const char *s, size_t len )
+{
+	const unsigned char *p = (const unsigned char *) s;
+	const unsigned char *end = p + len;
+	char tmp[CSBUF];
+	size_t n, k;
+
+	while (p < end) {
+		n = g->csn ? 0 : csAscii(p, (size_t)(end - p));
+		if (n == (size_t)(end - p) || n >= CSRUN) {
+			if ((*g->feed)(g, (const char *) p, n) != 0)
+				return(-1);
+			p += n;
+			continue;
+		}
+		for (k = 0; p < end && k <= CSBUF - CSMAX; ) {
+			if (*p < 0x80 && g->csn == 0) {
+				n = csAscii(p, (size_t)(end - p));
+				if (n >= CSRUN)
+					break;
+				if (n > CSBUF - k)
+					n = CSBUF - k;
+				memcpy(tmp + k, p, n);
+				k += n;
+				p += n;
+			}
+			else
+				k += (size_t) csByte(g, *p++, tmp + k);
+		}
+		if (k > 0 && (*g->feed)(g, tmp, k) != 0)
+			return(-1);
+	}
+	return(0);
+}
+/*
+ * end of input: a UTF-8 character which was never finished
+ */
+int
+csFlush( ENCTX *g )
+{
+	char tmp[CSMAX];
+	int k;
+
+	if (g->csn == 0)
+		return(0);
+	k = csBad(g, tmp);
+	return((*g->feed)(g, tmp, (size_t) k));
+}
+/*
+ * the length of the run of ASCII at the start of "p"
+ */
+static size_t
+csAscii( const unsigned char *p, size_t len )
+{
+	size_t i = 0;
+#if defined(__SSE2__)
+	unsigned int m;
+#else
+	unsigned long w;
+#endif
+
+#if defined(__AVX2__)
+	for ( ; i + 32 <= len; i += 32) {
+		m = (unsigned int) _mm256_movemask_epi8(
+			_mm256_loadu_si256((const __m256i *)(p + i)));
+		if (m != 0)
+			return(i + (size_t) __builtin_ctz(m));
+	}
+#endif
+#if defined(__SSE2__)
+	for ( ; i + 16 <= len; i += 16) {
+		m = (unsigned int) _mm_movemask_epi8(
+			_mm_loadu_si128((const __m128i *)(p + i)));
+		if (m != 0)
+			return(i + (size_t) __builtin_ctz(m));
+	}
+#else
+	for ( ; i + sizeof(w) <= len; i += sizeof(w)) {
+		memcpy(&w, p + i, sizeof(w));
+		if (w & (~0UL / 255 * 128))
+			break;
+	}
+#endif
+	while (i < len && p[i] < 0x80)
+		i++;
+	return(i);
+}
+/*
+ * convert one byte, not ASCII or in the middle of a UTF-8 character, into
+ * "out". returns the number of bytes put there.
+ */
+static int
+csByte( ENCTX *g, int c, char *out )
+{
+	static const unsigned long least[5] = { 0, 0, 0x80, 0x800, 0x10000 };
+	int k;
+
+	if (g->charset != CS_UTF8)
+		return(csPut(c < 0x80 ? (unsigned long) c :
+			     csMap[g->charset - CS_MAP][c - 0x80], out));
+	if (g->csn > 0) {
+		if ((c & 0xc0) != 0x80) {
+			k = csBad(g, out);
+			return(k + csByte(g, c, out + k));
+		}
+		g->csb[g->csl++] = (unsigned char) c;
+		g->csc = g->csc << 6 | (unsigned long)(c & 0x3f);
+		if (--g->csn > 0)
+			return(0);
+		if (g->csc < least[g->csl] || g->csc > 0x10ffff ||
+		    (g->csc >= 0xd800 && g->csc < 0xe000))
+			return(csBad(g, out));
+		g->csl = 0;
+		return(csPut(g->csc, out));
+	}
+	if (c < 0x80) {
+		*out = (char) c;
+		return(1);
+	}
+	if (c >= 0xc2 && c < 0xe0) {
+		g->csn = 1;
+		g->csc = (unsigned long)(c & 0x1f);
+	}
+	else if (c >= 0xe0 && c < 0xf0) {
+		g->csn = 2;
+		g->csc = (unsigned long)(c & 0x0f);
+	}
+	else if (c >= 0xf0 && c < 0xf5) {
+		g->csn = 3;
+		g->csc = (unsigned long)(c & 0x07);
+	}
+	else
+		return(csPut(csMap[0][c - 0x80], out));
+	g->csb[0] = (unsigned char) c;
+	g->csl = 1;
+	return(0);
+}
+/*
+ * the bytes of a UTF-8 character which turned out not to be one, as
+ * windows-1252
+ */
+static int
+csBad( ENCTX *g, char *out )
+{
+	int i, k;
+
+	for (i = k = 0; i < g->csl; i++)
+		k += csPut(csMap[0][g->csb[i] - 0x80], out + k);
+	g->csn = 0;
+	g->csl = 0;
+	return(k);
+}
+/*
+ * Unicode character "u" as ISO-8859-1, into "out". returns the number of
+ * bytes put there.
+ */
+static int
+csPut( unsigned long u, char *out )
+{
+	size_t lo, hi, i;
+
+	if (u < 0x80 || (u >= 0xa0 && u < 0x100)) {
+		*out = (char) u;
+		return(1);
+	}
+	if (u >= 0x100 && u < 0x180 && latinA[u - 0x100] != ' ') {
+		*out = latinA[u - 0x100];
+		return(1);
+	}
+	switch (u) {
+	case 0x132:
+		memcpy(out, "IJ", 2);
+		return(2);
+	case 0x133:
+		memcpy(out, "ij", 2);
+		return(2);
+	case 0x152:
+		memcpy(out, "OE", 2);
+		return(2);
+	case 0x153:
+		memcpy(out, "oe", 2);
+		return(2);
+	}
+	if (u >= 0x300 && u < 0x370)
+		return(0);
+	lo = 0;
+	hi = sizeof(csSubst) / sizeof(csSubst[0]);
+	while (lo < hi) {
+		i = (lo + hi) / 2;
+		if (csSubst[i].u < u)
+			lo = i + 1;
+		else if (csSubst[i].u > u)
+			hi = i;
+		else {
+			memcpy(out, csSubst[i].s, strlen(csSubst[i].s));
+			return((int) strlen(csSubst[i].s));
+		}
+	}
+	*out = '?';
+	return(1);
+}
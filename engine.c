@@ -0,0 +1,1033 @@
+/*
+ * Name: engine.c
+ *
+ * Function: libenriched converter for MIME Rich Text (RFC 1341) and
+ *	Enriched Text (RFC 1563). This is the tokenizer from rt2ps and
+ *	et2ps, working on a conversion context rather than global variables.
+ *
+ *	The two dialects differ in their keywords, in what a newline in
+ *	the input means, in the "<<" escape (RFC 1563 only) and in how
+ *	justification nests. Rather than one converter testing the dialect
+ *	as it goes, this file is compiled once for each, with DIALECT
+ *	defined as EN_RICHTEXT or EN_ENRICHED, and the code for the other
+ *	dialect is left out by the preprocessor. The Makefile builds
+ *	rtengine.o and etengine.o from it.
+ *
+ * Author: Tom Lang
+ *
+ * Date: 11/4/93 version 1 (rt2ps)
+ *	 02/1/94 version 2 - major rewrite, moving much function to the
+ *				generated PostScript code.
+ *	 07/05/94 et2ps
+ *
+ * Data Format: 7-bit ASCII character strings formatted in accordance
+ *	with RFC 1341 or RFC 1563.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "enpriv.h"
+
+#ifndef DIALECT
+#error "compile with -DDIALECT=EN_RICHTEXT or -DDIALECT=EN_ENRICHED"
+#endif
+#define RICHTEXT (DIALECT == EN_RICHTEXT)
+
+/*
+ * the keywords recognized by this program, but not necessarily all legal
+ * keywords, are listed in rt2ps.keys and et2ps.keys. the mkhash program
+ * turns each list into an include file, rtkeys.h or etkeys.h, which
+ * defines a K_ code for each keyword and a perfect hash function,
+ * keyLookup(), to recognize them.
+ */
+#if RICHTEXT
+
+/* length of longest keyword (RFC says allow 40 chars plus <,/, and > ) */
+#define MAXKEYLEN 43
+
+#include "rtkeys.h"
+
+#define engFeed rtFeed
+#define engFlush rtFlush
+#define engKeyword rtKeyword
+
+#else
+
+/* length of longest keyword (RFC says allow 60 chars plus <,/, and > ) */
+#define MAXKEYLEN 63
+
+#include "etkeys.h"
+
+/*
+ * the "newline" keyword is not a <> delimited token
+ */
+#define K_NL		MAXKEY
+
+#define engFeed etFeed
+#define engFlush etFlush
+#define engKeyword etKeyword
+
+#endif
+
+#if RICHTEXT
+/*
+ * RFC 1341: justifcation flags are used as bit flags, to allow nesting and
+ * also allow more tolerance of syntax errors like unbalanced token pairs.
+ *
+ * left justifcation implies no special processing of the output. centering
+ * and right justification require extra work.
+ *
+ * if both left and right justification are turned on, the output is fully
+ * justified. note that this is more than what is requried in the RFC - may
+ * be a problem, maybe a feature, maybe nobody cares...
+ *
+ * centering takes precedence over other values.
+ *
+ * if justification is turned on or off in the middle of
+ * a line, the action applies to the whole line. the RFC is fuzzy on this,
+ * but seems to imply this is how it should work.
+ */
+#define L_JUST 1
+#define R_JUST 2
+#define CENTER 4
+
+/*
+ * this table converts the justification bit flags to values for the
+ * PostScript JU macro. JU 0 = left, JU 1 = center, JU 2 = right, JU 3 = full
+ */
+static int jtab[8] = {
+	0,	/* no flags, default to left justify */
+	0,	/* L_JUST */
+	2,	/* R_JUST */
+	3,	/* L_JUST & R_JUST */
+	1,	/* CENTER */
+	1,	/* CENTER & anything else = CENTER */
+	1,
+	1
+};
+#else
+/*
+ * RFC 1563: justification attributes nest, on a stack.
+ *
+ * left justifcation implies no special processing of the output. centering,
+ * full justification, and right justification require extra work.
+ *
+ * the most recent (innermost) command takes precedence.
+ *
+ * if justification is turned on or off in the middle of
+ * a line, a line break is assumed before and after the formatting change.
+
+ * these values correspond to the parameters for the
+ * PostScript JU macro. JU 0 = left, JU 1 = center, JU 2 = right, JU 3 = full
+ */
+#define L_JUST 0
+#define CENTER 1
+#define R_JUST 2
+#define F_JUST 3
+#endif
+
+/*
+ * a character which the converter has no case for, and which just goes
+ * into the token. most of them are letters, above '>'.
+ */
+#define ORDINARY(c)	((c) > '>' || ((c) != '\n' && (c) != '\t' && \
+			 (c) != '\r' && (c) != ' ' && (c) != '<' && (c) != '>'))
+
+static void tokenOutput( ENCTX * );
+static int  keywordMatch( ENCTX * );
+static void controlOutput( ENCTX *, int );
+static void newline( ENCTX * );
+static void justifyKey( ENCTX *, int, int );
+#if !RICHTEXT
+static int  ahead( ENCTX *, int );
+static int  newlineAhead( ENCTX *, int );
+static int  ltAhead( ENCTX *, int, const char * );
+static void pushJustify( ENCTX *, int );
+static void popJustify( ENCTX *, int );
+static void toggleFont( ENCTX *, int );
+#endif
+static void countToken( ENCTX *, int, int );
+static void countIndent( ENCTX *, int );
+static void tokenAt( ENCTX *, const char * );
+static void tokenChar( ENCTX *, int );
+static void tokenSave( ENCTX * );
+static int  tokenRoom( ENCTX *, size_t );
+static void tokenEnd( ENCTX * );
+static const char *tokenText( ENCTX *, size_t * );
+
+/*
+ * convert a block of input
+ */
+int
+engFeed( ENCTX *g, const char *p, size_t len )
+{
+	const char *end = p + len;
+	int c;			/* input stream character */
+	int key;		/* keyword index */
+
+#if !RICHTEXT
+	/*
+	 * the previous block may have ended just when we needed to
+	 * look at the next character
+	 */
+	if(g->pending != PEND_NONE && p < end)
+		p += ahead(g, (unsigned char) *p);
+#endif
+
+	while(p < end) {
+		c = (unsigned char) *p++;
+		switch ((char) c) {
+#if RICHTEXT
+		/*
+		 * "newline" in the input stream is treated as white
+		 * space, or ignored if it immediately follows a keyword.
+		 */
+		case '\n' :
+			if(g->atMargin == 0) {
+				if(g->space == 0) {
+					tokenOutput(g);
+					g->space = 1;
+				}
+				tokenChar(g, ' ');
+				tokenOutput(g);
+			}
+			break;
+#else
+		/*
+		 * "newline" in the input stream.
+		 * An isolated newline is treated as a space.
+		 * N consecutive newlines are treated as N-1 line breaks.
+		 */
+		case '\n' :
+			/*
+			 * if at the left margin, we're in a newline
+			 * sequence.
+			 */
+			if(g->atMargin) {
+				controlOutput(g, K_NL+1);
+			}
+			else if(p == end)
+				g->pending = PEND_NL;
+			else
+				p += newlineAhead(g, (unsigned char) *p);
+			break;
+#endif
+		/*
+		 * tab character
+		 */
+		case '\t' :
+			tokenOutput(g);
+			enTab(g);
+			break;
+		/*
+		 * carriage returns are ignored, which leaves a gap in the
+		 * token, see tokenAt()
+		 */
+		case '\r' :
+			break;
+		/*
+		 * space character
+		 */
+		case ' ' :
+			if(g->space == 0) {
+				tokenOutput(g);
+				g->space = 1;
+			}
+			tokenAt(g, p - 1);
+			break;
+#if RICHTEXT
+		case '<' :
+			tokenOutput(g);
+			tokenAt(g, p - 1);
+			g->keyword = 1;
+			break;
+#else
+		/*
+		 * two consecutive <'s are interpreted as a single,
+		 * literal '<'. else, this is the beginning of a keyword.
+		 */
+		case '<' :
+			if(g->space)
+				tokenOutput(g);
+			if(p == end)
+				g->pending = PEND_LT;
+			else
+				p += ltAhead(g, (unsigned char) *p, p - 1);
+			break;
+#endif
+		case '>':
+			if(g->space)
+				tokenOutput(g);
+			tokenAt(g, p - 1);
+			if(g->keyword) {
+				key = keywordMatch(g);
+				if(key == 0) {
+					if(g->showTags)
+						tokenOutput(g);
+					else {
+						g->c = 0;
+						g->ts = g->te;
+						g->space = 0;
+						g->keyword = 0;
+						g->atMargin = 0;
+					}
+				}
+				else {
+					controlOutput(g, key);
+#if !RICHTEXT
+					if(g->error) {
+						tokenEnd(g);
+						return(-1);
+					}
+#endif
+				}
+			}
+			break;
+		/*
+		 * the characters which are special to the PostScript
+		 * interpreter, \, ( and ), are escaped as the token is sent,
+		 * see outEsc()
+		 */
+		default:
+			/*
+			 * guard against extraneous stuff in the input
+			 */
+#if 0
+			if ( iscntrl( (char) c) ) {
+				c = (int) '.';
+			}
+#endif
+			/*
+			 * add the character to the token, and the ordinary
+			 * characters after it with it, since it's only a
+			 * matter of moving the end of the token along
+			 */
+			if(g->space)
+				tokenOutput(g);
+			tokenAt(g, p - 1);
+			while(p < end && ORDINARY((unsigned char) *p))
+				p++;
+			g->te = p;
+			if(g->keyword == 0)
+				g->atMargin = 0;
+		}
+	}
+	tokenEnd(g);
+	return(0);
+}
+/*
+ * end of input
+ */
+void
+engFlush( ENCTX *g )
+{
+#if !RICHTEXT
+	if(g->pending != PEND_NONE)
+		(void) ahead(g, EOF);
+#endif
+	/*
+	 * if text in the buffer, dump it out
+	 */
+	if (g->atMargin == 0)
+		tokenOutput(g);
+}
+#if !RICHTEXT
+/*
+ * resolve lookahead left pending at the end of the previous block. "c" is
+ * the first character of this block, or EOF at the end of the input.
+ * returns 1 if the character was used up, 0 if it still has to be
+ * processed.
+ */
+static int
+ahead( ENCTX *g, int c )
+{
+	int p = g->pending;
+
+	g->pending = PEND_NONE;
+	if(p == PEND_NL)
+		return(newlineAhead(g, c));
+	return(ltAhead(g, c, NULL));
+}
+/*
+ * a newline not at the left margin. "c" is the character after it.
+ * if that is a newline too, it's a line break, otherwise the newline is
+ * treated as a space. returns 1 if "c" was used up.
+ */
+static int
+newlineAhead( ENCTX *g, int c )
+{
+	if (c == '\n') {
+		tokenOutput(g);
+		controlOutput(g, K_NL+1);
+		return(1);
+	}
+	if(g->space == 0) {
+		tokenOutput(g);
+		g->space = 1;
+	}
+	tokenChar(g, ' ');
+	return(0);
+}
+/*
+ * a '<'. "c" is the character after it. two consecutive <'s are
+ * interpreted as a single, literal '<'. else, this is the beginning of a
+ * keyword. "lt" is where the '<' is in the block, or NULL if it was at
+ * the end of the previous one. returns 1 if "c" was used up.
+ */
+static int
+ltAhead( ENCTX *g, int c, const char *lt )
+{
+	if (c != '<')
+		tokenOutput(g);
+	if (lt != NULL)
+		tokenAt(g, lt);
+	else
+		tokenChar(g, '<');
+	if (c == '<')
+		return(1);
+	g->keyword = 1;
+	return(0);
+}
+#endif
+/*
+ * output a 4-tuple token of the form:
+ * [ (string) size font action ] C
+ *
+ * where:
+ *	(string) is a character string to be output
+ *	size is the font's point size, or 0 for no change
+ *	font is the name of the font, or "x" for no change
+ *	action is the action code for this token:
+ *	0 = show character string
+ *	1 = show underlined character string
+ *	2 = show space(s)
+ *	3 = show underlined space(s)
+ *	4 = tab
+ *	5 = underlined tab
+ *	6 = show subscript			(RFC 1341 only)
+ *	7 = show underlined subscript		(RFC 1341 only)
+ *	8 = show superscript			(RFC 1341 only)
+ *	9 = show underlined superscript		(RFC 1341 only)
+ *	12 = show run of words and spaces	(with the -w flag, see run.c)
+ *	13 = show underlined run
+ *	the trailing "C" is a macro which causes the token to be processed.
+ *
+ *	There are shortcut macros for spaces and tabs:
+ *	S = single space character
+ *	US = single underlined space
+ *	T = tab character
+ *	UT = underlined tab character
+ *
+ *	With the -c flag, words and spaces which come with a font are
+ *	sent as "(string) W", or U if underlined, and the font as
+ *	"size font G" only when it changes. See enToken().
+ */
+static void
+tokenOutput( ENCTX *g )
+{
+	int action;
+	int fontSize;
+	const char *s;
+	size_t len;
+
+	if(g->c == 0 && g->ts == g->te)
+		return;
+	if(g->suppress == 0) {
+		s = tokenText(g, &len);
+		if((g->space) && (len == 1)) {
+			if(g->underline)
+				enCount(g, us);
+			else
+				enCount(g, s);
+			if(g->layout)
+				layToken(g, " ", 1, 0, -1, 2+g->underline);
+			else if(g->runs)
+				runToken(g, " ", 1, 0, -1, 2+g->underline);
+			else
+				enToken(g, " ", 1, 0, -1, 2+g->underline);
+		}
+		else {
+			/*
+			 * determine the "action code" for the "C" macro
+			 */
+#if RICHTEXT
+			action = (g->super*8)+(g->sub*6)+(g->space*2)+g->underline;
+#else
+			action = (g->space*2)+g->underline;
+#endif
+
+			/*
+			 * there's no checking for too many nested <smaller>
+			 * keywords, resulting in a 0 or negative font size.
+			 * we'll leave the global variable alone so that
+			 * corectly nested </smaller> keywords will eventually
+			 * restore it. however, a font size smaller than 6
+			 * will not be sent to the "C" macro by rt2ps. et2ps
+			 * has always sent it as is.
+			 */
+#if RICHTEXT
+			fontSize = (g->fs < 6) ? 6 : g->fs;
+#else
+			fontSize = g->fs;
+#endif
+			if(g->st)
+				countToken(g, fontSize, action);
+			if(g->layout)
+				layToken(g, s, len, fontSize,
+					 g->mask, action);
+			else if(g->runs)
+				runToken(g, s, len, fontSize,
+					 g->mask, action);
+			else
+				enToken(g, s, len, fontSize, g->mask, action);
+		}
+	}
+	g->c = 0;
+	g->ts = g->te;
+	g->space = 0;
+	g->keyword = 0;
+	g->atMargin = 0;
+}
+/*
+ * a character string delimited by < > has been found. see if it matches a
+ * known keyword. this is a case-insensitive compare. zero is returned if
+ * no match. a positive integer is returned if a match is found, equal to
+ * the keyword code + 1. if the keyword is an "off" keyword, e.g. </bold>,
+ * the return code is negated.
+ *
+ * for example, the keyword code for <bold> is 2. this routine will return
+ * 3 if the keyword is <bold> or -3 if the keyword is </bold>.
+ */
+static int
+keywordMatch( ENCTX *g )
+{
+	size_t len;
+	const char *s = tokenText(g, &len);
+	const char *end = &s[len-1];	/* the closing '>' */
+	int off = 0;
+	int k;
+
+	if(*++s == '/') {
+		s++;
+		off = 1;
+	}
+	if ((k = keyLookup(s, (int)(end-s))) < 0) {
+		enCount(g, unknown);
+		return(0);
+	}
+	if (off)
+		enCount(g, keyOff[k]);
+	else
+		enCount(g, keyOn[k]);
+	return((off) ? -(k+1) : (k+1));
+}
+/*
+ * a keyword has been matched in the input stream, so it's time to
+ * process the associated operation. the key value + 1 is passed in.
+ * if the key is negative, it represents turning an attribute off, e.g. /bold.
+ * if it's positive, it represents turning an attribute on, e.g. italic.
+ * some keywords don't have an off attribute, e.g. there's no /nl. if one of
+ * these is encountered, the "off" is silently ignored.
+ */
+#define AttrOff (key < 0)
+static void
+controlOutput( ENCTX *g, int key )
+{
+	int k = abs(key)-1;
+
+#if RICHTEXT
+	/*
+	 * special case: check for inside <comment>
+	 */
+	if( !((g->suppress) && (k != K_COMMENT))) {
+#else
+	{
+#endif
+	  switch(k) {
+	  /* <nl> */
+	  case K_NL:
+		newline(g);
+		break;
+	  /* <bold> */
+	  case K_BOLD:
+		if AttrOff
+			g->mask &= ~BOLD;
+		else
+			g->mask |= BOLD;
+		break;
+	  /* <italic */
+	  case K_ITALIC:
+		if AttrOff
+			g->mask &= ~ITALIC;
+		else
+			g->mask |= ITALIC;
+		break;
+	  /* <fixed> */
+	  case K_FIXED:
+		if AttrOff
+			g->mask &= ~FIXED;
+		else
+			g->mask |= FIXED;
+		break;
+	  /* <underline> */
+	  case K_UNDERLINE:
+		if AttrOff
+			g->underline = 0;
+		else
+			g->underline = 1;
+		break;
+	  /* <center> */
+	  case K_CENTER:
+		justifyKey(g, key, CENTER);
+		break;
+	  /* <flushleft> */
+	  case K_FL:
+		justifyKey(g, key, L_JUST);
+		break;
+	  /* <flushright> */
+	  case K_FR:
+		justifyKey(g, key, R_JUST);
+		break;
+	  /* <indent> */
+	  case K_INDENT:
+		countIndent(g, AttrOff ? -1 : 1);
+		if AttrOff {
+			if(g->atMargin)
+				enOp(g, LAY_DLM, "DLM\n\n");
+			else
+				enOp(g, LAY_DDLM, "DDLM\n\n");
+		}
+		else {
+			if(g->atMargin)
+				enOp(g, LAY_ILM, "ILM\n\n");
+			else
+				enOp(g, LAY_DILM, "DILM\n\n");
+		}
+		break;
+	  /* <indentright> */
+	  case K_INDENTR:
+		countIndent(g, AttrOff ? -1 : 1);
+		if AttrOff {
+			if(g->atMargin)
+				enOp(g, LAY_DRM, "DRM\n\n");
+			else
+				enOp(g, LAY_DDRM, "DDRM\n\n");
+		}
+		else {
+			if(g->atMargin)
+				enOp(g, LAY_IRM, "IRM\n\n");
+			else
+				enOp(g, LAY_DIRM, "DIRM\n\n");
+		}
+		break;
+	  /* <bigger> */
+	  case K_BIGGER:
+		if AttrOff
+			g->fs -=2;
+		else
+			g->fs +=2;
+		g->ffs = g->fs;
+		break;
+	  /* <smaller> */
+	  case K_SMALLER:
+		if AttrOff
+			g->fs +=2;
+		else
+			g->fs -=2;
+		g->ffs = g->fs;
+		break;
+#if RICHTEXT
+	  /* <lt> */
+	  case K_LT:
+		if(g->layout)
+			layToken(g, "<", 1, 0, -1, 0);
+		else {
+			enEndRun(g);
+			outLit(&g->out, "[(<) 0 x 0] C\n");
+		}
+		break;
+	  /* <superscript> */
+	  case K_SUPER:
+		if AttrOff {
+			g->super = 0;
+			if(g->scaled) {
+				g->fs = g->ffs;
+				g->scaled = 0;
+			}
+		}
+		else {
+			g->super = 1;
+			if(g->scaled == 0) {
+				g->fs /= 2;
+				g->scaled = 1;
+			}
+			g->sub = 0;
+			g->space = 0;
+		}
+		break;
+	  /* <subscript> */
+	  case K_SUB:
+		if AttrOff {
+			g->sub = 0;
+			if(g->scaled) {
+				g->fs = g->ffs;
+				g->scaled = 0;
+			}
+		}
+		else {
+			g->sub = 1;
+			if(g->scaled == 0) {
+				g->fs /= 2;
+				g->scaled = 1;
+			}
+			g->super = 0;
+			g->space = 0;
+		}
+		break;
+	  /* <outdent> */
+	  case K_OUTDENT:
+		countIndent(g, AttrOff ? 1 : -1);
+		if AttrOff {
+			if(g->atMargin)
+				enOp(g, LAY_ILM, "ILM\n\n");
+			else
+				enOp(g, LAY_DILM, "DILM\n\n");
+		}
+		else {
+			if(g->atMargin)
+				enOp(g, LAY_DLM, "DLM\n\n");
+			else
+				enOp(g, LAY_DDLM, "DDLM\n\n");
+		}
+		break;
+	  /* <outdentright> */
+	  case K_OUTDENTR:
+		countIndent(g, AttrOff ? 1 : -1);
+		if AttrOff {
+			if(g->atMargin)
+				enOp(g, LAY_IRM, "IRM\n\n");
+			else
+				enOp(g, LAY_DIRM, "DIRM\n\n");
+		}
+		else {
+			if(g->atMargin)
+				enOp(g, LAY_DRM, "DRM\n\n");
+			else
+				enOp(g, LAY_DDRM, "DDRM\n\n");
+		}
+		break;
+	  /* <comment> */
+	  case K_COMMENT:
+		if AttrOff
+			g->suppress = 0;
+		else
+			g->suppress = 1;
+		break;
+	  /* <np> */
+	  case K_NP:
+		enCount(g, np);
+		enOp(g, LAY_NP, "NP\n");
+		break;
+#else
+	  /* <flushboth> */
+	  case K_FB:
+		justifyKey(g, key, F_JUST);
+		break;
+	  /* <nofill> */
+	  case K_NOFILL:
+		justifyKey(g, key, L_JUST);
+		break;
+	  /* <param> */
+	  case K_PARAM:
+		if AttrOff
+			g->suppress = 0;
+		else
+			g->suppress = 1;
+		break;
+	  /* <excerpt> */
+	  case K_EXCERPT:
+		countIndent(g, AttrOff ? -1 : 1);
+		if (g->atMargin == 0) {
+			newline(g);
+		}
+		if AttrOff {
+			enOp(g, LAY_DLM, "DLM\n");
+			toggleFont(g, 0);
+		}
+		else {
+			enOp(g, LAY_ILM, "ILM\n");
+			toggleFont(g, 1);
+		}
+		break;
+#endif
+	  default:
+		fprintf(stderr, "INVALID KEYWORD\n");
+  	  }
+	}
+	/*
+	 * whatever was in the token, a keyword or spaces at the start of
+	 * a line, is dropped, and the word after it isn't spaced
+	 */
+	g->c = 0;
+	g->ts = g->te;
+	g->space = 0;
+	g->keyword = 0;
+}
+/*
+ * subroutine: process a line break.
+ * 	this is <nl> in RFC 1341. in RFC 1563 it is called when 2
+ *	consecutive newline characters are found, or when justification
+ *	mode is changed.
+ */
+static void
+newline( ENCTX *g )
+{
+	enCount(g, nl);
+	enOp(g, LAY_NL, "NL\n");
+#if RICHTEXT
+	if(g->justifyOff) {
+		g->justify &= ~g->justifyOff;
+		g->justifyOff = 0;
+		enJustifyOutput(g, jtab[g->justify]);
+	}
+#endif
+	g->atMargin = 1;
+}
+#if RICHTEXT
+/*
+ * a justification keyword. turning an attribute off takes effect at the
+ * next line break, unless we're at the left margin already.
+ */
+static void
+justifyKey( ENCTX *g, int key, int flag )
+{
+	if AttrOff {
+		g->justifyOff |= flag;
+		if(g->atMargin) {
+			g->justify &= ~g->justifyOff;
+			g->justifyOff = 0;
+			enJustifyOutput(g, jtab[g->justify]);
+		}
+	}
+	else {
+		if(g->atMargin) {
+			g->justify &= ~g->justifyOff;
+			g->justifyOff = 0;
+		}
+		g->justify |= flag;
+		enJustifyOutput(g, jtab[g->justify]);
+	}
+}
+#else
+/*
+ * a justification keyword. it starts a new line, and the justification
+ * is pushed or popped.
+ */
+static void
+justifyKey( ENCTX *g, int key, int justify )
+{
+	if (g->atMargin == 0) {
+		newline(g);
+	}
+	if AttrOff {
+		popJustify(g, justify);
+		enJustifyOutput(g, g->justify);
+	}
+	else {
+		pushJustify(g, justify);
+		enJustifyOutput(g, g->justify);
+	}
+}
+/*
+ * push justification attributes onto a stack. this allows nesting, for
+ * example, of <flushleft>, <flushright>, <flushboth>, and <center>.
+ */
+static void
+pushJustify( ENCTX *g, int justify )
+{
+	g->jstack[g->jsp] = g->justify;
+	if (++g->jsp >= MAXJSTACK) {
+		enFatal(g, "Internal error, justify stack overflow");
+		return;
+	}
+	if (g->st && g->jsp > g->st->jstack)
+		g->st->jstack = g->jsp;
+	g->justify = justify;
+}
+/*
+ * pop justification attributes off a stack. this allows nesting, for
+ * example, of <flushleft>, <flushright>, <flushboth>, and <center>.
+ */
+static void
+popJustify( ENCTX *g, int justify )
+{
+	if (g->justify != justify) {
+		if (g->spec) {
+			g->error = 1;
+			return;
+		}
+		fprintf(stderr, "Warning: Incorrect nesting of justification, output may be weird.\n");
+	}
+	if (--g->jsp < 0) {
+		enFatal(g, "Internal error, justify stack underflow");
+		return;
+	}
+	g->justify = g->jstack[g->jsp];
+}
+/*
+ * subroutine: toggle the main font between Helvetica and TimesRoman, based
+ *	on the "alt" parameter. alt=true means set the alternate font,
+ *	alt=false means set the main font.
+ *
+ *	the default main font is Helvetica, and the alternate is TimesRoman.
+ *	the polarity can be reversed by command line switch, which sets the
+ *	main font to TimesRoman and the alternate font to Helvetica.
+ */
+static void
+toggleFont( ENCTX *g, int alt )
+{
+	if(g->layout) {
+		layFamily(g, alt ^ g->altFont);
+		return;
+	}
+	enEndRun(g);
+	enFamily(g, alt ^ g->altFont);
+	outChar(&g->out, '\n');
+}
+#endif
+/*
+ * with the stats option: count a token for the C macro, and whether its
+ * font or size differs from the one before
+ */
+static void
+countToken( ENCTX *g, int size, int action )
+{
+	struct enStats *st = g->st;
+
+	st->token[action]++;
+	if (g->mask != g->smask) {
+		st->fonts++;
+		g->smask = g->mask;
+	}
+	if (size != g->ssize) {
+		st->sizes++;
+		g->ssize = size;
+	}
+}
+/*
+ * with the stats option: indentation, on the left or right, is one level
+ * deeper (delta = 1) or shallower (delta = -1)
+ */
+static void
+countIndent( ENCTX *g, int delta )
+{
+	if (g->st == NULL)
+		return;
+	g->depth += delta;
+	if (g->depth > g->st->indent)
+		g->st->indent = g->depth;
+}
+/*
+ * the token being collected is the first "c" characters in the token
+ * buffer, followed by the characters from "ts" to "te" in the block
+ * being converted. usually it's all in the block, and tokenOutput()
+ * sends it straight from there. it's only copied to the buffer when the
+ * input doesn't follow on: at a carriage return, which is left out, a
+ * '<' of "<<" or a newline taken as a space, and at the end of a block.
+ *
+ * add the input character at "q" to the token
+ */
+static void
+tokenAt( ENCTX *g, const char *q )
+{
+	if (g->te != q) {
+		if (g->ts != g->te)
+			tokenSave(g);
+		g->ts = q;
+	}
+	g->te = q + 1;
+}
+/*
+ * add a character to the token which isn't where it would be in the
+ * input
+ */
+static void
+tokenChar( ENCTX *g, int c )
+{
+	if (g->ts != g->te)
+		tokenSave(g);
+	if (tokenRoom(g, 1) == 0)
+		g->buff[g->c++] = (char) c;
+}
+/*
+ * copy the characters of the token in the block to the token buffer
+ */
+static void
+tokenSave( ENCTX *g )
+{
+	size_t len = (size_t)(g->te - g->ts);
+
+	if (len > 0 && tokenRoom(g, len) == 0) {
+		memcpy(g->buff + g->c, g->ts, len);
+		g->c += len;
+	}
+	g->ts = g->te;
+}
+/*
+ * make room for "len" more characters in the token buffer. returns 0, or
+ * -1 if there's no memory.
+ */
+static int
+tokenRoom( ENCTX *g, size_t len )
+{
+	size_t max;
+	char *b;
+
+	if (len <= g->bmax - g->c)
+		return(0);
+	for (max = g->bmax ? g->bmax : BUFFSIZE; max - g->c < len; max *= 2)
+		;
+	if ((b = realloc(g->buff, max)) == NULL) {
+		enFatal(g, "Out of memory");
+		return(-1);
+	}
+	g->buff = b;
+	g->bmax = max;
+	return(0);
+}
+/*
+ * the end of a block: keep what there is of the token
+ */
+static void
+tokenEnd( ENCTX *g )
+{
+	tokenSave(g);
+	g->ts = g->te = NULL;
+}
+/*
+ * the text of the token, and its length in "len"
+ */
+static const char *
+tokenText( ENCTX *g, size_t *len )
+{
+	if (g->c == 0) {
+		*len = (size_t)(g->te - g->ts);
+		return(g->ts);
+	}
+	tokenSave(g);
+	*len = g->c;
+	return(g->buff);
+}
+/*
+ * the name of keyword "code", or NULL if there's no such keyword
+ */
+const char *
+engKeyword( int code )
+{
+	int i;
+
+	for (i = 0; i < KEYHASH; i++)
+		if (keytab[i].code == code)
+			return(keytab[i].name);
+	return(NULL);
+}
@@ -0,0 +1,413 @@
+/*
+ * Name: enpriv.h
+ *
+ * Function: libenriched internals, shared by the library front end
+ *	(enriched.c) and the converters for each dialect (engine.c, compiled
+ *	once for RFC 1341 and once for RFC 1563). Programs using the library
+ *	should only include enriched.h.
+ */
+#ifndef ENPRIV_H
+#define ENPRIV_H
+
+#include "enriched.h"
+#include "output.h"
+
+/*
+ * initial size of the token buffer, which grows to fit the longest token
+ */
+#define BUFFSIZE 1024
+
+/*
+ * depth of the justification attribute stack (RFC 1563 only)
+ */
+#define MAXJSTACK 16
+
+/*
+ * font attribute masks, designed so that they can OR together.
+ * note that font change from default (Helvetica) to fixed (Courier) is
+ * handled as an attribute change rather than a font change. this limits
+ * us to two fonts, but that's all that's required by MIME.
+ */
+#define BOLD 1
+#define ITALIC 2
+#define FIXED 4
+
+/*
+ *  PostScript page coordinates
+ *    measured in "points," where 72 points = 1 inch
+ *    lower left page corner = 0,0
+ *    8.5" x 11" paper, portrait orientation assumed
+ *    indentation unit is .5 inch, i.e. 36 points
+ */
+#define Y_TOP 720
+#define Y_BOT 72
+#define X_LEFT 72
+#define X_RIGHT 540
+#define NORMAL_FONT_SIZE 10
+#define SMALL_FONT_SIZE 6
+#define LINE_HEIGHT 12
+#define INDENT 36
+
+/*
+ * lookahead which couldn't be resolved because it ran off the end of
+ * a block of input. it is resolved by the first character of the next
+ * block, or by the end of the input.
+ */
+#define PEND_NONE 0		/* nothing pending */
+#define PEND_NL 1		/* newline, is the next one a newline too? */
+#define PEND_LT 2		/* '<', is the next one a '<' too? */
+
+/*
+ * the operators for a line or the page, for the host layout (layout.c).
+ * these are the PostScript macros of the same names.
+ */
+#define LAY_NL 0		/* new line */
+#define LAY_NP 1		/* new page */
+#define LAY_ILM 2		/* increment left margin */
+#define LAY_DLM 3		/* decrement left margin */
+#define LAY_DILM 4		/* increment left margin, delayed */
+#define LAY_DDLM 5		/* decrement left margin, delayed */
+#define LAY_IRM 6		/* increment right margin */
+#define LAY_DRM 7		/* decrement right margin */
+#define LAY_DIRM 8		/* increment right margin, delayed */
+#define LAY_DDRM 9		/* decrement right margin, delayed */
+
+/*
+ * a token on the line being laid out by the host
+ */
+struct layItem {
+  int action;		/* action code, as for the C macro */
+  int font;		/* font, an index into the AFM tables, or -1 for
+			   no change */
+  int size;		/* font size */
+  double w;		/* length, found in pass 1 */
+  size_t text;		/* offset of the string in the text buffer */
+  size_t len;		/* length of the string */
+};
+
+/*
+ * host layout state. most of it mirrors the variables of the PostScript
+ * prolog, in lower case.
+ */
+struct layout {
+  double lm, nlm;	/* left margin, and delayed left margin */
+  double rm, nrm;	/* right margin, and delayed right margin */
+  double x, y;		/* coordinates */
+  double rem;		/* length of the token which didn't fit the line */
+  double sc;		/* count of spaces in the line */
+  double l;		/* length of the line */
+  double adj;		/* padding of each space, for full justification */
+  int fh;		/* font height */
+  int mfh;		/* maximum font height in the line */
+  int ju;		/* justification, 0=left, 1=center, 2=right, 3=full */
+  int times;		/* flag: main font family is Times */
+  int font;		/* current font, or -1 for none yet */
+  int size;		/* current font size */
+  int pfont;		/* font last set in the output */
+  int psize;		/* and its size */
+  struct layItem *item;	/* tokens on the line */
+  int n;		/* number of tokens on the line */
+  int max;		/* room for this many */
+  char *text;		/* the tokens' strings */
+  size_t tn;		/* bytes of text */
+  size_t tmax;		/* room for this many */
+  int open;		/* flag: a page has been started, with -g */
+  size_t *page;		/* offset of each page in the output, and then
+			   of the trailer, with -g */
+  size_t npage;		/* number of pages output */
+  size_t pageno;	/* number of pages laid out */
+  int skip;		/* flag: the page is outside the range */
+  size_t maxpage;	/* room for this many offsets */
+};
+
+/*
+ * PDF output state (pdf.c)
+ */
+struct pdf {
+  struct output page;	/* content stream of the page being drawn */
+  char *buf;		/* where it collects */
+  size_t n;		/* bytes in buf */
+  size_t max;		/* room in buf */
+  int nomem;		/* flag: some of the page was lost */
+  size_t *obj;		/* offset of each object, by number */
+  size_t nobj;		/* next object number */
+  size_t maxobj;	/* room for this many offsets */
+  int *kid;		/* object number of each page */
+  size_t npage;		/* number of pages */
+  size_t maxpage;	/* room for this many */
+  double x, y;		/* current point */
+  double tw;		/* word spacing last set, Tw */
+  char msg[64];		/* the date line of the running header */
+};
+
+/*
+ * the MIME structure (mime.c): multiparts nested deeper than this are
+ * skipped, and a boundary is up to 70 characters, after "--"
+ */
+#define MIMEDEPTH 8
+#define MIMEBND 72
+
+/*
+ * a MIME message being walked, with the mime flag. all zero is the start
+ * of the message's header fields.
+ */
+struct mime {
+  int state;		/* in the header fields or the body, M_* */
+  int line;		/* where in the line, L_* */
+  char lb[MIMEBND];	/* the start of the line, while it may be a
+			   boundary */
+  size_t ln;		/* bytes in lb */
+  int level;		/* the multipart of the boundary, on its line */
+  int close;		/* flag: and it's the closing one */
+  int dn;		/* characters after the boundary so far, up to 2 */
+  int held;		/* flag: a line break of the part is held back */
+  int nb;		/* number of multiparts open */
+  char bnd[MIMEDEPTH][MIMEBND + 1];	/* "--" and each one's boundary */
+  size_t bl[MIMEDEPTH];	/* and its length */
+  int digest[MIMEDEPTH];	/* flag: it's a multipart/digest, whose
+				   parts are message/rfc822 by default */
+  char hdr[1024];	/* the header field being read */
+  size_t hn;		/* bytes in hdr */
+  int hend;		/* flag: its line has ended */
+  int hline;		/* flag: the line so far isn't empty */
+  int type;		/* the entity's type, MT_* */
+  int dialect;		/* EN_RICHTEXT or EN_ENRICHED, for MT_TEXT */
+  int enc;		/* its transfer encoding, TE_* */
+  char boundary[MIMEBND - 1];	/* its boundary parameter */
+  char charset[32];	/* its charset parameter */
+  int isDigest;		/* flag: it's a multipart/digest */
+  int body;		/* the type of the body being read, MT_* */
+  int found;		/* flag: the part has been found */
+  int done;		/* flag: and it's finished */
+  unsigned long q;	/* base64 bits so far */
+  int qn;		/* and the number of characters */
+  int qs;		/* quoted-printable state, after "=" */
+  int qc, qh;		/* the first hex digit after it, and its value */
+  int cr;		/* flag: a CR of the part is held back, in case
+			   it's the start of a line break */
+};
+
+/*
+ * longest run of words and spaces sent as one token (the -w flag), in
+ * characters of the input. a run longer than a line is broken by the
+ * prolog, but each break measures the rest of it again.
+ */
+#define RUNMAX 256
+
+/*
+ * a run of words and spaces in the same font, size and underlining,
+ * being collected for the C macro. the spaces after the last word are
+ * kept at the end of the text until it's known whether another word
+ * follows them.
+ */
+struct run {
+  int size;		/* font size */
+  int mask;		/* font attributes */
+  int action;		/* action code of the words, 0 or 1 */
+  int words;		/* number of words in the run */
+  int sc;		/* number of spaces between them */
+  size_t sp;		/* number of spaces after the last word */
+  int spFont;		/* flag: the spaces after the last word came with a
+			   font, i.e. there's more than one */
+  size_t n;		/* bytes of text, including those spaces */
+  char text[RUNMAX];	/* the words and spaces */
+};
+
+/*
+ * the things a document uses, which decide the parts of the prolog needed
+ * for the minimal prolog (the -m flag). each part is marked with a
+ * "%part:" line in paginate.ps.verbose, which mkincl turns into an entry
+ * of PSPARTS, in prolog.h.
+ */
+#define PS_FONT(i)	(1L << (i))	/* font i, as numbered in afm.h */
+#define PS_BASE		(1L << 12)	/* anything at all */
+#define PS_TEXT		(1L << 13)	/* lines laid out by the prolog */
+#define PS_LAYOUT	(1L << 14)	/* lines laid out here (-l) */
+#define PS_ULINE	(1L << 15)	/* underlined strings and spaces */
+#define PS_TAB		(1L << 16)	/* tabs */
+#define PS_SCRIPT	(1L << 17)	/* sub/superscripts (RFC 1341) */
+#define PS_RUN		(1L << 18)	/* runs of words (-w) */
+#define PS_COMPACT	(1L << 19)	/* the G, W and U macros (-c) */
+#define PS_BOX		(1L << 20)	/* box around each page (-b) */
+#define PS_HDR		(1L << 21)	/* running headers (-h) */
+
+/*
+ * the font for a font attribute mask, in the main font family "times"
+ */
+#define PS_MASK(m, times)	PS_FONT(((m) & FIXED ? 8 : (times) ? 4 : 0) + \
+					((m) & (BOLD|ITALIC)))
+
+/*
+ * the conversion context. this is the state which rt2ps and et2ps used
+ * to keep in global variables.
+ */
+struct enContext {
+  int dialect;		/* EN_RICHTEXT or EN_ENRICHED */
+  int (*feed)( ENCTX *, const char *, size_t );	/* dialect converter */
+  void (*flush)( ENCTX * );	/* dialect end of input */
+  int keyword;		/* flag: keyword just processed */
+  size_t c;		/* length of the token in the token buffer */
+  const char *ts, *te;	/* and the rest of it, in the block being
+			   converted, see tokenAt() */
+  int space;		/* flag: collecting white space. this is done to
+			   optimize the PostScript code - doing one command
+			   for multiple spaces rather than one each space */
+  int super;		/* flag: superscript (RFC 1341) */
+  int sub;		/* flag: subscript (RFC 1341) */
+  int scaled;		/* flag: font scaled for sub/super script (RFC 1341) */
+  int altFont;		/* flag: use alternate font, e.g. Times vs. Helvetica*/
+  int justify;		/* mask: justification attributes */
+  int justifyOff;	/* mask: justif. attrs to reset at <nl> (RFC 1341) */
+  int jsp;		/* justification stack index (RFC 1563) */
+  int fs;		/* current font size */
+  int pfs;		/* font size last sent with the G macro */
+  int ffs;		/* full font size */
+  int atMargin;		/* flag: at left margin now */
+  int prolog;		/* flag: pre-pend PostScript prolog to output */
+  int suppress;		/* flag: output suppressed (within a comment or
+			   param) */
+  int underline;	/* flag: underline attribute turned on/off */
+  int mask;		/* font mask: used to select from font array */
+  int pm;		/* font mask last sent with the G macro, or -1 */
+  int box;		/* flag: draw box around each page */
+  int showTags;		/* flag: show unrecognized MIME tags */
+  int hdr;		/* flag: print running headers */
+  int pending;		/* lookahead pending at end of block, PEND_* */
+  int error;		/* flag: fatal error, conversion abandoned */
+  int layout;		/* flag: lay out the lines here, not in PostScript */
+  int runs;		/* flag: send words and spaces in runs */
+  int compact;		/* flag: send words and fonts in short form */
+  int minimal;		/* flag: only the parts of the prolog used, so the
+			   output is kept in the spool until the end */
+  int pages;		/* flag: DSC pages, each one standing alone */
+  int from, to;		/* page range, 0 for no limit */
+  int pdfOut;		/* flag: PDF rather than PostScript, see pdf.c */
+  int mime;		/* flag: the input is a MIME message, see mime.c */
+  int charset;		/* the input's character set, 0 for ISO-8859-1,
+			   which isn't converted, see charset.c */
+  unsigned long csc;	/* the UTF-8 character being decoded */
+  int csn;		/* and the number of bytes of it still to come */
+  unsigned char csb[4];	/* its bytes so far */
+  int csl;		/* and how many */
+  int spec;		/* flag: converting a chunk of the input on a guess,
+			   so give up rather than print a message, see
+			   par.c */
+  int squeeze;		/* SQ_LZW or SQ_FLATE until the compressed stream
+			   has ended, or 0, see squeezeStart() */
+  int resident;		/* use the prolog installed in the printer, 1 with
+			   a fallback, 2 without, see prolog() */
+  int times;		/* flag: main font family is now Times */
+  unsigned long uses;	/* what the document uses, PS_ flags */
+  int jstack[MAXJSTACK];	/* justification stack (RFC 1563) */
+  char *buff;		/* the part of a token which can't be sent
+			   straight from the input is copied here */
+  size_t bmax;		/* size of the token buffer */
+  struct output out;	/* PostScript output buffer */
+  enSink sink;		/* where the output goes, when it's spooled or
+			   compressed */
+  void *arg;		/* and the sink's first argument */
+  struct spool spool;	/* output kept for the minimal prolog */
+  struct squeeze *sq;	/* the compressed stream, or NULL */
+  struct layout lay;	/* host layout state */
+  struct run run;	/* run of words being collected */
+  struct pdf pdf;	/* PDF output state */
+  struct mime msg;	/* the MIME message, with the mime flag */
+  struct enStats *st;	/* counters, with the stats option, or NULL */
+  int smask, ssize;	/* font and size of the last token counted */
+  int depth;		/* nesting of indentation, for the counters */
+  double wall0, cpu0;	/* when the phase being timed started */
+};
+
+/*
+ * count something in the stats, if they're being kept. "field" is a
+ * member of struct enStats, e.g. token[action].
+ */
+#define enCount(g, field)	((g)->st ? (void) (g)->st->field++ : (void) 0)
+
+/*
+ * output the run of words being collected, if any. this has to be done
+ * before anything else goes into the PostScript.
+ */
+#define enEndRun(g)	((g)->run.n > 0 ? runEnd(g) : (void) 0)
+
+/*
+ * output one of the line or page operators: the PostScript macro "text",
+ * or the same operation in the host layout
+ */
+#define enOp(g, op, text)	((g)->layout ? layOp(g, op) : \
+				 (enEndRun(g), outLit(&(g)->out, text)))
+
+/*
+ * table of font names, indexed by attribute mask
+ */
+extern char *enFont[8];
+
+/*
+ * services the library front end provides to the dialect converters
+ */
+void enToken( ENCTX *, const char *, size_t, int, int, int );
+void enTab( ENCTX * );
+void enJustifyOutput( ENCTX *, int );
+void enFamily( ENCTX *, int );
+void enFatal( ENCTX *, char * );
+
+/*
+ * the host layout, layout.c
+ */
+void layOpen( ENCTX * );
+void layClose( ENCTX * );
+void layToken( ENCTX *, const char *, size_t, int, int, int );
+void layOp( ENCTX *, int );
+void layJustify( ENCTX *, int );
+void layFamily( ENCTX *, int );
+void layFinish( ENCTX * );
+double layWidth( int, int, const char *, size_t );
+
+/*
+ * runs of words, run.c
+ */
+void runToken( ENCTX *, const char *, size_t, int, int, int );
+void runEnd( ENCTX * );
+
+/*
+ * PDF output, pdf.c
+ */
+void pdfOpen( ENCTX * );
+void pdfPageOpen( ENCTX * );
+void pdfPageClose( ENCTX * );
+void pdfFinish( ENCTX * );
+void pdfClose( ENCTX * );
+void pdfMove( ENCTX *, double, double );
+void pdfRMove( ENCTX *, double, double );
+void pdfFont( ENCTX *, int, int );
+void pdfText( ENCTX *, const char *, size_t, double, double );
+void pdfLine( ENCTX *, double );
+
+/*
+ * MIME message front end, mime.c
+ */
+int  mimeFeed( ENCTX *, const char *, size_t );
+int  mimeFlush( ENCTX * );
+
+/*
+ * parallel conversion, par.c
+ */
+int  parFeed( ENCTX *, const char *, size_t, int );
+
+/*
+ * character set conversion, charset.c
+ */
+int  csFeed( ENCTX *, const char *, size_t );
+int  csFlush( ENCTX * );
+
+/*
+ * the dialect converters
+ */
+int  rtFeed( ENCTX *, const char *, size_t );
+void rtFlush( ENCTX * );
+int  etFeed( ENCTX *, const char *, size_t );
+void etFlush( ENCTX * );
+const char *rtKeyword( int );
+const char *etKeyword( int );
+
+#endif /* ENPRIV_H */
@@ -0,0 +1,813 @@
+/*
+ * Name: enriched.c
+ *
+ * Function: libenriched front end. Creates and destroys conversion
+ *	contexts, hands input to the converter for the context's dialect,
+ *	and produces the parts of the PostScript output which don't depend
+ *	on the dialect: the prolog, the epilog, tabs and font definitions.
+ *	With the layout option the tokens go to the host layout, layout.c,
+ *	instead.
+ *
+ * Author: Tom Lang
+ *
+ * Data Format: see engine.c.
+ */
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "enpriv.h"
+#include "prolog.h"
+
+/*
+ * table of font names, indexed by attribute mask, which is
+ * an OR of bold, italic, and fixed font.
+ *
+ * when the prolog code is written to standard output, macros defining
+ * short-hand names for the fonts are defined.
+ */
+char *enFont[8] = {
+	"f1",
+	"f1b",
+	"f1i",
+	"f1bi",
+	"f2",
+	"f2b",
+	"f2i",
+	"f2bi"
+	};
+
+static int  convert( ENCTX *, const char *, size_t );
+static void prolog( ENCTX * );
+static void procset( struct output * );
+static void epilog( ENCTX * );
+static void squeezeStart( ENCTX * );
+static void squeezeStop( ENCTX * );
+static int  unspool( ENCTX * );
+static double seconds( clockid_t );
+static void clockStart( ENCTX * );
+static void clockStop( ENCTX *, int );
+
+/*
+ * fill in the default options, i.e. those of rt2ps and et2ps when
+ * run without any flags.
+ */
+void
+enDefaults( struct enOptions *opt )
+{
+	memset(opt, 0, sizeof(*opt));
+	opt->prolog = 1;
+	opt->fs = NORMAL_FONT_SIZE;
+}
+/*
+ * create a conversion context for input in the given dialect. the
+ * PostScript output is passed to "sink", with "arg" as its first argument.
+ * the prolog is produced right away, so the sink may be called before
+ * this returns.
+ *
+ * returns NULL if the dialect is unknown or there's no memory.
+ */
+ENCTX *
+enOpen( int dialect, const struct enOptions *opt, enSink sink, void *arg )
+{
+	ENCTX *g;
+
+	if ((g = calloc(1, sizeof(*g))) == NULL)
+		return(NULL);
+	if (opt->stats) {
+		if ((g->st = calloc(1, sizeof(*g->st))) == NULL) {
+			free(g);
+			return(NULL);
+		}
+		g->smask = -1;
+		g->ssize = -1;
+		clockStart(g);
+	}
+	g->dialect = dialect;
+	switch (dialect) {
+	case EN_RICHTEXT:
+		g->feed = rtFeed;
+		g->flush = rtFlush;
+		break;
+	case EN_ENRICHED:
+		g->feed = etFeed;
+		g->flush = etFlush;
+		break;
+	default:
+		free(g->st);
+		free(g);
+		return(NULL);
+	}
+	g->sink = sink;
+	g->arg = arg;
+	if (opt->squeeze && !opt->pages && !opt->from && !opt->to && !opt->pdf) {
+		g->squeeze = opt->squeeze == 1 ? SQ_LZW : SQ_FLATE;
+		if ((g->sq = malloc(sizeof(*g->sq))) == NULL ||
+		    squeezeInit(g->sq, g->squeeze, sink, arg) != 0) {
+			free(g->sq);
+			free(g->st);
+			free(g);
+			return(NULL);
+		}
+	}
+	g->fs = opt->fs;
+	g->ffs = opt->fs;
+	g->atMargin = 1;
+	g->prolog = opt->prolog;
+	g->pm = -1;
+	g->box = opt->box;
+	g->altFont = opt->altFont;
+	g->showTags = opt->showTags;
+	g->hdr = opt->hdr;
+	g->pdfOut = opt->pdf;
+	g->charset = opt->charset;
+	g->mime = opt->mime;
+	g->pages = opt->pages || opt->from > 0 || opt->to > 0 || opt->pdf;
+	g->layout = opt->layout || g->pages;
+	g->from = opt->from;
+	g->to = opt->to;
+	g->runs = opt->runs;
+	g->compact = opt->compact;
+	g->resident = opt->resident;
+	g->times = opt->altFont;
+	g->uses = PS_BASE | (g->layout ? PS_LAYOUT : PS_TEXT);
+	if (g->box)
+		g->uses |= PS_BOX;
+	if (g->hdr)
+		g->uses |= PS_HDR | PS_FONT(4);	/* in Times-Roman */
+	if (g->layout)
+		layOpen(g);
+
+	/*
+	 * output PostScript prolog code. for the minimal prolog, it has to
+	 * wait until the end, when it's known what the document uses, and
+	 * the document is kept until then. a prolog installed in the
+	 * printer is all or nothing, see prolog(), and with DSC pages the
+	 * page offsets have to count the prolog. PDF has no prolog, just
+	 * the objects every page uses.
+	 */
+	if (g->pdfOut) {
+		outInit(&g->out, sink, arg);
+		pdfOpen(g);
+	}
+	else if (opt->minimal && !opt->resident && !g->pages && g->prolog) {
+		g->minimal = 1;
+		outInit(&g->out, spoolSink, &g->spool);
+	}
+	else {
+		outInit(&g->out, sink, arg);
+		prolog(g);
+		if (g->squeeze)
+			squeezeStart(g);
+	}
+	if (g->st)
+		clockStop(g, EN_PROLOG);
+	return(g);
+}
+/*
+ * convert a block of input. blocks may be of any size, and a token or
+ * keyword may be split across blocks.
+ *
+ * returns 0, or -1 if the input can't be converted (an error message
+ * has been written to stderr). once a conversion fails, further input
+ * is ignored.
+ */
+int
+enFeed( ENCTX *g, const char *s, size_t len )
+{
+	int rc;
+
+	if (g->error)
+		return(-1);
+	if (g->st == NULL)
+		return(convert(g, s, len));
+	clockStart(g);
+	g->st->in += len;
+	rc = convert(g, s, len);
+	clockStop(g, EN_CONVERT);
+	return(rc);
+}
+/*
+ * convert the whole of the input, or the rest of it, which is all in
+ * memory at "s", on up to "jobs" threads. the output is the same as from
+ * enFeed(), but a long document converts several times as fast, unless
+ * it's laid out here or is a MIME message, which are converted in one
+ * piece. see par.c.
+ *
+ * returns 0, or -1 as enFeed() does.
+ */
+int
+enParallel( ENCTX *g, const char *s, size_t len, int jobs )
+{
+	int rc;
+
+	if (g->error)
+		return(-1);
+	if (g->layout || g->mime)
+		return(enFeed(g, s, len));
+	if (g->st == NULL)
+		return(parFeed(g, s, len, jobs));
+	clockStart(g);
+	g->st->in += len;
+	rc = parFeed(g, s, len, jobs);
+	clockStop(g, EN_CONVERT);
+	return(rc);
+}
+/*
+ * end of input: wrap up the PostScript output and pass anything still
+ * buffered to the sink.
+ *
+ * returns 0, or -1 if the conversion failed.
+ */
+int
+enFinish( ENCTX *g )
+{
+	if (g->error)
+		return(-1);
+	if (g->st)
+		clockStart(g);
+	if (g->mime && mimeFlush(g) != 0)
+		return(-1);
+	if (g->charset && csFlush(g) != 0)
+		return(-1);
+	(*g->flush)(g);
+	if (g->error)
+		return(-1);
+	if (g->st) {
+		clockStop(g, EN_CONVERT);
+		clockStart(g);
+	}
+	epilog(g);
+	if (g->minimal && unspool(g) != 0) {
+		enFatal(g, "Out of memory");
+		return(-1);
+	}
+	if (g->squeeze)
+		squeezeStop(g);
+	if (!g->pdfOut)
+		outLit(&g->out, "%%EOF\n");
+	outFlush(&g->out);
+	if (g->st) {
+		g->st->out = outPos(&g->out);
+		clockStop(g, EN_EPILOG);
+	}
+	return(0);
+}
+/*
+ * output just the prolog for the given options (whether or not
+ * opt->prolog is set). a program converting many documents can produce
+ * the prolog once, and then open each document with opt->prolog = 0.
+ *
+ * returns 0, or -1 if there's no memory.
+ */
+int
+enProlog( const struct enOptions *opt, enSink sink, void *arg )
+{
+	struct enOptions o;
+	ENCTX *g;
+
+	o = *opt;
+	o.prolog = 1;
+	o.minimal = 0;
+	o.squeeze = 0;
+	if ((g = enOpen(EN_RICHTEXT, &o, sink, arg)) == NULL)
+		return(-1);
+	outFlush(&g->out);
+	enClose(g);
+	return(0);
+}
+/*
+ * with opt->pages, after enFinish(): the number of pages, and in "*off",
+ * where each one starts in the output, followed by where the trailer
+ * starts. a page runs from its offset to the next.
+ */
+size_t
+enPages( ENCTX *g, const size_t **off )
+{
+	*off = g->lay.page;
+	return(g->lay.page ? g->lay.npage : 0);
+}
+/*
+ * set opt->from and opt->to from a page range as given to -r: "n-m",
+ * "n-" (to the end), "-m" (from the start) or "n" (just the one page).
+ * returns 0, or -1 if it isn't a range.
+ */
+int
+enRange( const char *s, struct enOptions *opt )
+{
+	char *end;
+	long from = 0;
+	long to = 0;
+
+	if (*s != '-') {
+		from = strtol(s, &end, 10);
+		if (end == s || from < 1 || from > INT_MAX)
+			return(-1);
+		s = end;
+		to = from;
+	}
+	if (*s == '-') {
+		s++;
+		to = 0;
+		if (*s != 0) {
+			to = strtol(s, &end, 10);
+			if (end == s || to < 1 || to > INT_MAX)
+				return(-1);
+			s = end;
+		}
+	}
+	if (*s != 0 || (to > 0 && to < from) || (from == 0 && to == 0))
+		return(-1);
+	opt->from = (int) from;
+	opt->to = (int) to;
+	return(0);
+}
+/*
+ * with opt->stats, after enFinish(): what the conversion did. NULL without
+ * the option.
+ */
+const struct enStats *
+enStats( ENCTX *g )
+{
+	return(g->st);
+}
+/*
+ * the name of keyword "code" in the context's dialect, as counted in
+ * struct enStats, or NULL if there's no such keyword
+ */
+const char *
+enKeyword( ENCTX *g, int code )
+{
+	if (g->dialect == EN_RICHTEXT)
+		return(rtKeyword(code));
+	return(etKeyword(code));
+}
+/*
+ * destroy a context. any output which hasn't been passed to the sink
+ * by enFinish() is discarded.
+ */
+void
+enClose( ENCTX *g )
+{
+	layClose(g);
+	pdfClose(g);
+	spoolFree(&g->spool);
+	if (g->sq != NULL)
+		squeezeFree(g->sq);
+	free(g->sq);
+	free(g->st);
+	free(g->buff);
+	free(g);
+}
+/*
+ * a fatal error: the conversion can't continue. like the original
+ * filters, the message goes to stderr and whatever output has been
+ * produced so far is passed on.
+ */
+void
+enFatal( ENCTX *g, char *msg )
+{
+	if (g->spec) {
+		g->error = 1;
+		return;
+	}
+	fprintf(stderr, "%s\n", msg);
+	enEndRun(g);
+	if (g->minimal)
+		(void) unspool(g);
+	if (g->squeeze)
+		squeezeStop(g);
+	outFlush(&g->out);
+	g->error = 1;
+}
+/*
+ * output a token. "s" is the string, as it is in the input, "mask" the
+ * font attributes, or -1 for the "don't care" font x. a single space
+ * without a font is the S or US macro. otherwise it's a token array for
+ * the C macro or, with the compact option, words and spaces are just the
+ * string and the W or U macro, with a G macro in front if the font isn't
+ * the one last sent.
+ */
+void
+enToken( ENCTX *g, const char *s, size_t len, int size, int mask, int action )
+{
+	if(action == 1 || action == 3)
+		g->uses |= PS_ULINE;
+	else if(action >= 6 && action <= 9)
+		g->uses |= PS_SCRIPT;
+	if(mask >= 0)
+		g->uses |= PS_MASK(mask, g->times);
+	if(mask < 0 && (action == 2 || action == 3) && len == 1) {
+		if(action == 3)
+			outLit(&g->out, "US\n");
+		else
+			outLit(&g->out, "S\n");
+		return;
+	}
+	if(g->compact && mask >= 0 && action < 4) {
+		g->uses |= PS_COMPACT;
+		if(size != g->pfs || mask != g->pm) {
+			outInt(&g->out, size);
+			outChar(&g->out, ' ');
+			outStr(&g->out, enFont[mask]);
+			outLit(&g->out, " G\n");
+			g->pfs = size;
+			g->pm = mask;
+		}
+		outChar(&g->out, '(');
+		outEsc(&g->out, s, len);
+		if(action & 1)
+			outLit(&g->out, ") U\n");
+		else
+			outLit(&g->out, ") W\n");
+		return;
+	}
+	outLit(&g->out, "[(");
+	outEsc(&g->out, s, len);
+	outLit(&g->out, ") ");
+	if(mask < 0)
+		outLit(&g->out, "0 x ");
+	else {
+		outInt(&g->out, size);
+		outChar(&g->out, ' ');
+		outStr(&g->out, enFont[mask]);
+		outChar(&g->out, ' ');
+
+		/*
+		 * the C macro sets the font height itself, so the next
+		 * W or U needs a G in front of it to set it back
+		 */
+		g->pm = -1;
+	}
+	outInt(&g->out, action);
+	outLit(&g->out, "] C\n");
+}
+/*
+ * output a tab
+ */
+void
+enTab( ENCTX *g )
+{
+	if(!g->suppress) {
+		if(g->underline)
+			enCount(g, ut);
+		else
+			enCount(g, t);
+		if(g->layout)
+			layToken(g, "", 0, 0, -1, 4+g->underline);
+		else {
+			enEndRun(g);
+			g->uses |= PS_TAB;
+			if(g->underline)
+				outLit(&g->out, "UT ");
+			else
+				outLit(&g->out, "T ");
+		}
+	}
+}
+/*
+ * output a change of justification, i.e. set the PostScript JU variable
+ */
+void
+enJustifyOutput( ENCTX *g, int ju )
+{
+	if (g->layout) {
+		layJustify(g, ju);
+		return;
+	}
+	enEndRun(g);
+	outLit(&g->out, "/JU ");
+	outInt(&g->out, ju);
+	outLit(&g->out, " def\n");
+}
+/*
+ * define the short-hand names for the main font family, f1 through f1bi,
+ * as Times (times = true) or Helvetica (times = false). the font last
+ * sent with the G macro may have changed with them.
+ */
+void
+enFamily( ENCTX *g, int times )
+{
+	g->pm = -1;
+	g->times = times;
+	if (times) {
+		outLit(&g->out, "(Times-Roman) cvlit /f1 exch def ");
+		outLit(&g->out, "(Times-Bold) cvlit /f1b exch def ");
+		outLit(&g->out, "(Times-Italic) cvlit /f1i exch def ");
+		outLit(&g->out, "(Times-BoldItalic) cvlit /f1bi exch def ");
+	}
+	else {
+		outLit(&g->out, "(Helvetica) cvlit /f1 exch def ");
+		outLit(&g->out, "(Helvetica-Bold) cvlit /f1b exch def ");
+		outLit(&g->out, "(Helvetica-Oblique) cvlit /f1i exch def ");
+		outLit(&g->out, "(Helvetica-BoldOblique) cvlit /f1bi exch def ");
+	}
+}
+/*
+ * Output PostScript prolog code
+ *
+ * The main body of the prolog is read from a static data structure, which
+ * contains the pagination macros. The data structure is in prolog.h,
+ * which is built by the Perl program mkincl. The source for the prolog is
+ * paginate.ps. This is a "stripped" version of the PostScript code. The
+ * human-readable source is in paginate.ps.verbose. This latter file is the
+ * one which should be edited if PostScript code changes are required. The
+ * Perl program pstrip converts paginate.ps.verbose to paginate.ps. The
+ * purpose for doing all this is to make the program self contained, rather
+ * than require shipping an extra file with it, containing the PostScript code.
+ */
+#define PSCOPY \
+	"%Copyright (c) 1996 H&L Software, Inc.\n" \
+	"%All rights reserved\n"
+#define PSHEAD \
+	"%!PS\n" PSCOPY \
+	"%%BeginProlog\n"
+#define PSDSC \
+	"%!PS-Adobe-3.0\n" PSCOPY \
+	"%%Pages: (atend)\n" \
+	"%%EndComments\n" \
+	"%%BeginProlog\n"
+#define PSTAIL \
+	"\n%%EndProlog\n%%BeginSetup\n"
+static char psprolog[] = PSHEAD PSCODE PSTAIL;
+
+/*
+ * the prolog installed in the printer is a ProcSet resource named PSNAME,
+ * the macros in a dictionary of their own. on a level 1 printer, which
+ * has no resources, the dictionary goes in userdict under that name.
+ *
+ * the installing job leaves the job server with exitserver, so that the
+ * resource outlives it. a document looks the prolog up, and with the
+ * fallback, first checks that it's there and defines it for the length
+ * of the job if it isn't. either way, the dictionary goes on the
+ * dictionary stack, with userdict above it for the variables the
+ * macros set.
+ */
+#define PSINSTALL \
+	"%!PS-Adobe-3.0 ExitServer\n" PSCOPY \
+	"%%BeginExitServer: 0\n" \
+	"serverdict begin 0 exitserver\n" \
+	"%%EndExitServer\n" \
+	"%%BeginResource: procset " PSNAME "\n"
+#define PSREF \
+	"%%IncludeResource: procset " PSNAME "\n" \
+	"/" PSNAME "\n"
+#define PSFIND \
+	"dup /findresource where\n" \
+	"{pop /ProcSet resourcestatus {pop pop true} {false} ifelse}\n" \
+	"{userdict exch known} ifelse not {\n"
+#define PSGET \
+	"/findresource where {pop /ProcSet findresource} {userdict exch get} ifelse\n" \
+	"begin userdict begin"
+
+/*
+ * the parts of PSCODE, for the minimal prolog: what each is needed for,
+ * PS_ flags, and where it is
+ */
+static const struct {
+	unsigned long uses;
+	size_t off;
+	size_t len;
+} psparts[] = { PSPARTS };
+
+static void
+prolog( ENCTX *g )
+{
+	time_t tloc;
+	size_t i;
+
+	if(g->prolog) {
+
+		/*
+		 * the header comments and the PostScript macros from the
+		 * static data structure are one constant block, which
+		 * goes out in a single piece. for the minimal prolog, it's
+		 * just the parts of the macros the document uses, and for
+		 * the resident prolog, a reference to the copy in the printer.
+		 */
+		if(g->resident) {
+			if(g->pages)
+				outLit(&g->out, PSDSC);
+			else
+				outLit(&g->out, PSHEAD);
+			outLit(&g->out, PSREF);
+			if(g->resident == 1) {
+				outLit(&g->out, PSFIND);
+				procset(&g->out);
+				outLit(&g->out, "} if\n");
+			}
+			outLit(&g->out, PSGET PSTAIL);
+		}
+		else if(g->minimal) {
+			outLit(&g->out, PSHEAD);
+			for(i = 0; i < sizeof(psparts) / sizeof(psparts[0]); i++)
+				if(psparts[i].uses & g->uses)
+					outWrite(&g->out, psprolog +
+						 sizeof(PSHEAD) - 1 +
+						 psparts[i].off,
+						 psparts[i].len);
+			outLit(&g->out, PSTAIL);
+		}
+		else if(g->pages) {
+			outLit(&g->out, PSDSC);
+			outWrite(&g->out, psprolog + sizeof(PSHEAD) - 1,
+				 sizeof(psprolog) - sizeof(PSHEAD));
+		}
+		else
+			outLit(&g->out, psprolog);
+
+		/*
+		 * set flag for drawing box (or not) around each page. with
+		 * DSC pages, each page draws its own box and header.
+		 */
+		if(g->box) {
+			outLit(&g->out, "/BOX true def\n");
+			if(!g->pages)
+				outLit(&g->out, "DB	% draw box for first page\n");
+		}
+		else
+			outLit(&g->out, "/BOX false def\n");
+
+		/*
+		 * set flag for running header (or not)
+		 */
+		if(g->hdr) {
+			outLit(&g->out, "/HDR true def\n/PG 1 def\n");
+			time(&tloc);
+			outLit(&g->out, "/MSG (Message converted on ");
+			outStr(&g->out, ctime(&tloc));
+			outLit(&g->out, ") def\n");
+			if(!g->pages)
+				outLit(&g->out, "PH	% print header for first page\n");
+		}
+		else
+			outLit(&g->out, "/HDR false def\n");
+
+		/*
+		 * define short-hand literal names for fonts
+		 */
+		enFamily(g, g->altFont);
+		outLit(&g->out, "(Courier) cvlit /f2 exch def ");
+		outLit(&g->out, "(Courier-Bold) cvlit /f2b exch def ");
+		outLit(&g->out, "(Courier-Oblique) cvlit /f2i exch def ");
+		outLit(&g->out, "(Courier-BoldOblique) cvlit /f2bi exch def\n\n");
+
+		/*
+		 * set the page margins
+		 */
+/*** to override the stuff in the PostScript prolog, this is the place ***/
+
+		outLit(&g->out, "%%EndSetup\n");
+	}
+}
+/*
+ * the code defining the resident prolog, see PSINSTALL
+ */
+static void
+procset( struct output *o )
+{
+	outLit(o, "/" PSNAME " 200 dict dup begin\n");
+	outWrite(o, psprolog + sizeof(PSHEAD) - 1, sizeof(PSCODE) - 1);
+	outLit(o, "\nend /defineresource where {pop /ProcSet defineresource pop}\n");
+	outLit(o, "{userdict 3 1 roll put} ifelse\n");
+}
+/*
+ * output a job which installs the prolog in the printer, for the
+ * documents converted with opt->resident. it stays there until the
+ * printer is restarted.
+ *
+ * returns 0, or -1 if there's no memory.
+ */
+int
+enInstall( enSink sink, void *arg )
+{
+	struct output *o;
+
+	if ((o = malloc(sizeof(*o))) == NULL)
+		return(-1);
+	outInit(o, sink, arg);
+	outLit(o, PSINSTALL);
+	procset(o);
+	outLit(o, "%%EndResource\n%%EOF\n");
+	outFlush(o);
+	free(o);
+	return(0);
+}
+/*
+ * pass a block of input through the stages in front of the converter:
+ * the MIME message, then the character set
+ */
+static int
+convert( ENCTX *g, const char *s, size_t len )
+{
+	if (g->mime)
+		return(mimeFeed(g, s, len));
+	if (g->charset)
+		return(csFeed(g, s, len));
+	return((*g->feed)(g, s, len));
+}
+/*
+ * for the minimal prolog: the document has been kept in the spool, and
+ * now that it's known what it uses, the prolog goes out, then the document.
+ *
+ * returns 0, or -1 if some of the document was lost
+ */
+static int
+unspool( ENCTX *g )
+{
+	int rc;
+
+	outFlush(&g->out);
+	outInit(&g->out, g->sink, g->arg);
+	prolog(g);
+	if (g->squeeze)
+		squeezeStart(g);
+	rc = spoolPlay(&g->spool, &g->out);
+	spoolFree(&g->spool);
+	g->minimal = 0;
+	return(rc);
+}
+/*
+ * wrap up the PostScript output. the dialect converter has already
+ * dumped out any text left in the token buffer.
+ */
+static void
+epilog( ENCTX *g )
+{
+	/*
+	 * cause final "showpage"
+	 */
+	enCount(g, np);
+	if (g->layout)
+		layFinish(g);
+	else {
+		enEndRun(g);
+		outLit(&g->out, "/BOX false def\n/HDR false def\n");
+		outLit(&g->out, "NP\n");
+	}
+}
+/*
+ * from here on, the PostScript goes through the compressing sink, which
+ * the line before it tells the printer to decode and run. the prolog
+ * stays as it is, so the DSC comments and the lookup of a resident
+ * prolog can still be seen by a spooler. the decompressing filter stops
+ * at its own end of data, which may leave the ~> that ends the ASCII85
+ * unread, so flushfile reads up to it. the ASCII85 filter is kept in ZF
+ * rather than on the operand stack, which the body of the document
+ * expects to find empty.
+ */
+static void
+squeezeStart( ENCTX *g )
+{
+	outLit(&g->out, "{/ZF currentfile /ASCII85Decode filter def\n");
+	if (g->squeeze == SQ_FLATE)
+		outLit(&g->out, "ZF /FlateDecode filter cvx exec ZF flushfile} exec\n");
+	else
+		outLit(&g->out, "ZF /LZWDecode filter cvx exec ZF flushfile} exec\n");
+	outFlush(&g->out);
+	g->sq->out.done = g->out.done;
+	outInit(&g->out, squeezeSink, g->sq);
+}
+/*
+ * end the compressed stream, and go back to writing to the sink
+ */
+static void
+squeezeStop( ENCTX *g )
+{
+	outFlush(&g->out);
+	squeezeEnd(g->sq);
+	outInit(&g->out, g->sink, g->arg);
+	g->out.done = g->sq->out.done;
+	g->squeeze = 0;
+}
+/*
+ * the time, in seconds, by clock "id"
+ */
+static double
+seconds( clockid_t id )
+{
+	struct timespec ts;
+
+	if (clock_gettime(id, &ts) != 0)
+		return(0);
+	return(ts.tv_sec + ts.tv_nsec / 1e9);
+}
+/*
+ * with the stats option, start timing a phase of the conversion
+ */
+static void
+clockStart( ENCTX *g )
+{
+	g->wall0 = seconds(CLOCK_MONOTONIC);
+	g->cpu0 = seconds(CLOCK_THREAD_CPUTIME_ID);
+}
+/*
+ * and add the time since then to "phase"
+ */
+static void
+clockStop( ENCTX *g, int phase )
+{
+	g->st->wall[phase] += seconds(CLOCK_MONOTONIC) - g->wall0;
+	g->st->cpu[phase] += seconds(CLOCK_THREAD_CPUTIME_ID) - g->cpu0;
+}
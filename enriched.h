@@ -0,0 +1,128 @@
+/*
+ * Name: enriched.h
+ *
+ * Function: libenriched, a library for converting MIME Rich Text (RFC 1341)
+ *	and Enriched Text (RFC 1563) to PostScript.
+ *
+ *	All of the conversion state lives in a context object, so any
+ *	number of conversions can be in progress at once in one process.
+ *	Input is pushed into the context in blocks of any size, and the
+ *	PostScript comes back through an output callback ("sink") which is
+ *	called each time the context's output buffer fills, and at the end.
+ *
+ *	A typical conversion:
+ *
+ *		struct enOptions opt;
+ *		ENCTX *ctx;
+ *
+ *		enDefaults(&opt);
+ *		ctx = enOpen(EN_ENRICHED, &opt, mySink, myArg);
+ *		while (more input)
+ *			if (enFeed(ctx, block, len) != 0)
+ *				... give up, the input can't be converted ...
+ *		enFinish(ctx);
+ *		enClose(ctx);
+ */
+#ifndef ENRICHED_H
+#define ENRICHED_H
+
+#include <stddef.h>
+
+/*
+ * the input dialects, named for the RFC which defines them
+ */
+#define EN_RICHTEXT	1341	/* text/richtext, as converted by rt2ps */
+#define EN_ENRICHED	1563	/* text/enriched, as converted by et2ps */
+
+/*
+ * conversion options. these are the command line flags of rt2ps and et2ps.
+ */
+struct enOptions {
+	int box;		/* flag: draw box around each page */
+	int prolog;		/* flag: pre-pend PostScript prolog to output */
+	int altFont;		/* flag: use Times rather than Helvetica */
+	int showTags;		/* flag: show unrecognized MIME tags */
+	int hdr;		/* flag: print running headers */
+	int fs;			/* default font size */
+	int layout;		/* flag: break and justify lines on the host */
+	int runs;		/* flag: send words and spaces in runs */
+	int compact;		/* flag: send words and fonts in short form */
+	int minimal;		/* flag: only the parts of the prolog used */
+	int resident;		/* use the prolog installed in the printer:
+				   1 with a fallback, 2 without */
+	int pages;		/* flag: DSC pages which stand alone, laid
+				   out as with the layout flag */
+	int from, to;		/* only output the pages from..to, 0 for
+				   no limit; implies the pages flag */
+	int stats;		/* flag: count what the conversion does, see
+				   enStats() */
+	int pdf;		/* flag: PDF rather than PostScript, laid out
+				   as with the pages flag */
+	int squeeze;		/* compress what follows the prolog: 1 with
+				   LZW (PostScript Level 2), 2 with Flate
+				   (Level 3), 0 not at all. ignored with the
+				   pages flag, a page range or pdf */
+	int charset;		/* the character set of the input, set by
+				   enCharset(); 0 is ISO-8859-1 (and so
+				   ASCII), which is printed as it is */
+	int mime;		/* flag: the input is a whole MIME message,
+				   whose text/enriched or text/richtext
+				   part is converted, in its own dialect */
+};
+
+/*
+ * what a conversion did, with the stats option. the tokens and keywords
+ * are counted as the converter finds them, whatever form they take in
+ * the output (host layout, runs, compact). the times are in seconds,
+ * for the three phases: the prolog, the conversion of the input, and
+ * the end of the document (which, for the minimal prolog, includes
+ * writing the prolog).
+ */
+#define EN_MAXACTION 16		/* action codes of the C macro */
+#define EN_MAXKEY 32		/* keyword codes */
+
+#define EN_PROLOG 0
+#define EN_CONVERT 1
+#define EN_EPILOG 2
+
+struct enStats {
+	size_t in;		/* bytes of input */
+	size_t out;		/* bytes of output */
+	size_t token[EN_MAXACTION];	/* tokens for C, by action code */
+	size_t s, us;		/* single spaces, the S and US macros */
+	size_t t, ut;		/* tabs, the T and UT macros */
+	size_t keyOn[EN_MAXKEY];	/* keywords, by code */
+	size_t keyOff[EN_MAXKEY];	/* and the ones turning them off */
+	size_t unknown;		/* tags which aren't keywords */
+	size_t fonts;		/* tokens in a different font from the last */
+	size_t sizes;		/* and in a different size */
+	size_t nl;		/* line breaks, NL */
+	size_t np;		/* page breaks, NP, including the last */
+	int indent;		/* deepest nesting of indentation */
+	int jstack;		/* deepest justification stack (RFC 1563) */
+	double wall[3];		/* real time of each phase */
+	double cpu[3];		/* and CPU time, of the calling thread */
+};
+
+/*
+ * output callback. "buf" is only valid until the callback returns.
+ */
+typedef void (*enSink)( void *arg, const char *buf, size_t len );
+
+typedef struct enContext ENCTX;
+
+void   enDefaults( struct enOptions * );
+ENCTX *enOpen( int, const struct enOptions *, enSink, void * );
+int    enFeed( ENCTX *, const char *, size_t );
+int    enParallel( ENCTX *, const char *, size_t, int );
+int    enFinish( ENCTX * );
+void   enClose( ENCTX * );
+int    enProlog( const struct enOptions *, enSink, void * );
+int    enInstall( enSink, void * );
+size_t enPages( ENCTX *, const size_t ** );
+int    enRange( const char *, struct enOptions * );
+int    enCharset( const char *, struct enOptions * );
+const struct enStats *enStats( ENCTX * );
+const char *enKeyword( ENCTX *, int );
+
+#endif /* ENRICHED_H */
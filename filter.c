@@ -0,0 +1,663 @@
+/*
+ * Name: filter.c
+ *
+ * Function: the rt2ps and et2ps filters, converting MIME Rich Text or
+ *	Enriched Text to PostScript. This is the command line interface,
+ *	the conversion is done by libenriched. The Makefile compiles it
+ *	once for each program, with DIALECT defined as EN_RICHTEXT (rt2ps)
+ *	or EN_ENRICHED (et2ps).
+ *
+ * Author: Tom Lang
+ *
+ * Date: 11/4/93 version 1 (rt2ps)
+ *	 02/1/94 version 2 - major rewrite, moving much function to the
+ *				generated PostScript code.
+ *	 07/05/94 et2ps
+ *
+ * Data Format: 7-bit ASCII character strings formatted in accordance
+ *	with RFC 1341 (rt2ps) or RFC 1563 (et2ps).
+ */
+#include <errno.h>
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "input.h"
+#include "output.h"
+#include "enriched.h"
+#include "server.h"
+#include "batch.h"
+
+#ifndef DIALECT
+#error "compile with -DDIALECT=EN_RICHTEXT or -DDIALECT=EN_ENRICHED"
+#endif
+
+/*
+ * the conversion itself is done by libenriched. this is just the
+ * command line interface.
+ */
+
+/*
+ * the most files, or threads, -j can ask for at once
+ */
+#define MAXJOBS 64
+
+/*
+ * place to save directory name from which program is launched
+ */
+static char dir[255];
+
+/*
+ * global static variables
+ */
+struct {
+  char *n;		/* pointer to program name */
+  char *d;		/* pointer to program directory name */
+  char *s;		/* socket name, in daemon mode */
+  char *o;		/* output directory, in batch mode */
+  int j;		/* number of files to convert at once */
+  char **f;		/* input files, in batch mode */
+  int nf;		/* number of input files */
+  int i;		/* flag: output the job installing the prolog */
+  char *x;		/* prefix of the file names for split pages */
+  char *st;		/* file for the stats, with --stats */
+} g = {
+  NULL,			/* n */
+  &dir[0],		/* d */
+  NULL,			/* s */
+  NULL,			/* o */
+  1,			/* j */
+  NULL,			/* f */
+  0,			/* nf */
+  0,			/* i */
+  NULL,			/* x */
+  NULL			/* st */
+};
+
+/*
+ * the long options: --stats=file, which writes what the conversion did to
+ * the file, as JSON, when it's finished, and --mime.
+ */
+static struct option longOpts[] = {
+  { "stats", required_argument, NULL, 'S' },
+  { "mime", no_argument, NULL, 'M' },
+  { NULL, 0, NULL, 0 }
+};
+
+/*
+ * with -x, the PostScript is kept here until the end, to be split into
+ * pages
+ */
+static struct {
+  char *buf;		/* the PostScript */
+  size_t n;		/* number of bytes in buf */
+  size_t max;		/* room in buf */
+  int nomem;		/* flag: some of it was lost */
+} mem;
+
+/*
+ * conversion options, set from the command line
+ */
+static struct enOptions opt;
+
+/*
+ * function prototypes
+ */
+int  getArgs( int, char ** );
+void memSink( void *, const char *, size_t );
+int  splitPages( ENCTX * );
+int  writeStats( ENCTX * );
+char *baseName( char *, char * );
+char *dirName( char *, char * );
+void showHelp();
+
+int
+main(int argc, char **argv)
+{
+	struct input in;	/* input buffer and cursor */
+	ENCTX *ctx;		/* conversion context */
+	int fd = 1;		/* PostScript goes to standard output */
+
+	/*
+	 * process command line arguments, bail out if there's a problem
+	 */
+	enDefaults( &opt );
+	if (getArgs( argc, argv ) != 0)
+		exit(1);
+
+	/*
+	 * the job which installs the prolog in the printer, for -k
+	 */
+	if (g.i) {
+		if (enInstall( outFd, &fd ) != 0) {
+			fprintf(stderr, "%s: out of memory\n", g.n);
+			exit(1);
+		}
+		exit(0);
+	}
+
+	/*
+	 * in daemon mode, serve conversion jobs until told to stop
+	 */
+	if (g.s != NULL)
+		exit(srvRun( g.s, DIALECT, &opt, g.n ));
+
+	/*
+	 * in batch mode, convert the files named on the command line
+	 */
+	if (g.nf > 0)
+		exit(batchRun( DIALECT, &opt, g.j, g.o, g.f, g.nf, g.n ));
+
+	/*
+	 * make standard input available as one buffer
+	 */
+	if (inOpen( &in, 0 ) != 0) {
+		perror(g.n);
+		exit(1);
+	}
+
+	/*
+	 * start the conversion, this outputs the PostScript prolog code
+	 */
+	if (g.x != NULL)
+		ctx = enOpen( DIALECT, &opt, memSink, NULL );
+	else
+		ctx = enOpen( DIALECT, &opt, outFd, &fd );
+	if (ctx == NULL) {
+		fprintf(stderr, "%s: out of memory\n", g.n);
+		exit(1);
+	}
+
+	/*
+	 * filter the buffer to stdout, on several threads with -j, and wrap
+	 * up the PostScript output
+	 */
+	if (enParallel( ctx, in.cur, (size_t)(in.end - in.cur), g.j ) != 0 ||
+	    enFinish( ctx ) != 0)
+		exit(1);
+	if (g.x != NULL && splitPages( ctx ) != 0)
+		exit(1);
+	if (g.st != NULL && writeStats( ctx ) != 0)
+		exit(1);
+	enClose( ctx );
+	inClose( &in );
+	exit (0);
+}
+/*
+ * this routine parses command line flags and arguments
+ */
+int
+getArgs( int argc, char **argv )
+{
+	int c;
+	int fs;
+	int rc = 0;
+	extern char     *optarg;
+	extern int      optind;
+	int		opterr = 0;
+
+	/*
+	 * get program name (for error msgs) and directory name (for
+	 * finding PostScript prolog file.
+	 */
+	g.n = baseName( g.n, argv[0] );
+	g.d = dirName( g.d, argv[0] );
+
+	/*
+	 * parse arguments
+	 */
+	while ((c=getopt_long(argc, argv, "bptlwcmkzigPx:r:C:s:hd:j:o:?",
+			      longOpts, NULL)) != EOF)
+		switch(c) {
+			
+		/*
+		 * 'b' flag causes a box to be drawn around the margins
+		 *	on each page.
+		 */
+		case 'b':
+			opt.box = 1;
+			break;
+		/*
+		 * 'p' flag suppresses pre-pending the PostScript prolog
+		 * 	to the output. this is useful when debugging, using
+		 *	the program as a filter for standard input and 
+		 *	interactively writing conversions to standard output.
+		 */
+		case 'p':
+			opt.prolog = 0;
+			break;
+		/*
+		 * 't' flag changes default font to "Times",
+		 *     rather than "Helvetica."
+		 */
+		case 't':
+			opt.altFont = 1;
+			break;
+		/*
+		 * 'l' flag causes the lines to be broken and justified
+		 *     here, using built in font metrics, rather than by
+		 *     the PostScript interpreter.
+		 */
+		case 'l':
+			opt.layout = 1;
+			break;
+		/*
+		 * 'w' flag causes words in the same font to be sent to
+		 *     the PostScript in runs, rather than one at a time.
+		 */
+		case 'w':
+			opt.runs = 1;
+			break;
+		/*
+		 * 'c' flag causes words and spaces to be sent in short
+		 *     form, with the font only when it changes.
+		 */
+		case 'c':
+			opt.compact = 1;
+			break;
+		/*
+		 * 'm' flag causes the prolog to be cut down to the fonts
+		 *     and macros the document uses. the output is held
+		 *     back until the end of the input, to find out what
+		 *     those are.
+		 */
+		case 'm':
+			opt.minimal = 1;
+			break;
+		/*
+		 * 'k' flag causes the output to use the prolog installed
+		 *     in the printer with -i, rather than carry its own.
+		 *     given once, the output checks for the prolog, and
+		 *     defines it if it isn't there. given twice, it just
+		 *     assumes it's there.
+		 */
+		case 'k':
+			if (opt.resident < 2)
+				opt.resident++;
+			break;
+		/*
+		 * 'z' flag compresses the output after the prolog, which
+		 *     the printer decodes with the filters of PostScript
+		 *     Level 2: LZW. given twice, it's Flate, which is
+		 *     smaller but needs a Level 3 printer.
+		 */
+		case 'z':
+			if (opt.squeeze < 2)
+				opt.squeeze++;
+			break;
+		/*
+		 * 'i' flag outputs the job which installs the prolog in
+		 *     the printer, for -k, instead of converting anything.
+		 */
+		case 'i':
+			g.i = 1;
+			break;
+		/*
+		 * 'g' flag causes the output to be divided into pages as
+		 *     the Document Structuring Conventions describe, each
+		 *     of which can be printed by itself. the lines are laid
+		 *     out here, as for 'l', since that's where the page
+		 *     breaks have to be known.
+		 */
+		case 'g':
+			opt.pages = 1;
+			break;
+		/*
+		 * 'P' flag writes PDF instead of PostScript. the lines are
+		 *     laid out here, as for 'l', and the options which
+		 *     only change the form of the PostScript are ignored.
+		 */
+		case 'P':
+			opt.pdf = 1;
+			break;
+		/*
+		 * 'x' flag followed by a prefix writes each page to a
+		 *     file of its own, named prefix1.ps, prefix2.ps and so
+		 *     on, rather than to standard output.
+		 */
+		case 'x':
+			opt.pages = 1;
+			g.x = optarg;
+			break;
+		/*
+		 * 'r' flag followed by a range of pages, "3-4", "3-", "-4"
+		 *     or "3", outputs only those pages. they're laid out
+		 *     as for 'g', and every one of them stands alone.
+		 */
+		case 'r':
+			if (enRange(optarg, &opt) != 0) {
+				fprintf(stderr, "%s: bad page range %s\n",
+					g.n, optarg);
+				rc = 1;
+			}
+			break;
+		/*
+		 * 'C' flag followed by the character set of the input,
+		 *     e.g. "utf-8", converts it to ISO-8859-1 for the
+		 *     prolog's fonts, rather than printing its bytes as
+		 *     they are.
+		 */
+		case 'C':
+			if (enCharset(optarg, &opt) != 0) {
+				fprintf(stderr, "%s: unknown character set %s\n",
+					g.n, optarg);
+				rc = 1;
+			}
+			break;
+		/*
+		 * 'u' flag causes unrecognized MIME tags to be shown
+		 *     in the output. useful for debugging.
+		 */
+		case 'u':
+			opt.showTags = 1;
+			break;
+		/*
+		 * 's' flag followed by an integer overrides the
+		 * default font size (10 pt)
+		 */
+		case 's':
+			fs = atoi(optarg);
+			if(errno)
+				perror(g.n);
+			if(fs > 0 && fs < 36)
+				opt.fs = fs;
+			break;
+		/*
+		 * 'h' flag causes printing of running headers
+		 */
+		case 'h':
+			opt.hdr = 1;
+			break;
+		/*
+		 * 'd' flag followed by a socket name runs the program as a
+		 * daemon, converting jobs sent to the socket. the other
+		 * flags become the defaults for each job.
+		 */
+		case 'd':
+			g.s = optarg;
+			break;
+		/*
+		 * 'j' flag followed by an integer sets the number of files
+		 * converted at once in batch mode, or the number of threads
+		 * converting standard input, up to MAXJOBS. 0 means one
+		 * for each processor.
+		 */
+		case 'j':
+			g.j = atoi(optarg);
+			if (g.j > MAXJOBS) {
+				fprintf(stderr, "%s: -j can't be more than %d\n",
+					g.n, MAXJOBS);
+				opterr++;
+				break;
+			}
+			if (g.j <= 0)
+				g.j = (int) sysconf(_SC_NPROCESSORS_ONLN);
+			if (g.j <= 0)
+				g.j = 1;
+			if (g.j > MAXJOBS)
+				g.j = MAXJOBS;
+			break;
+		/*
+		 * 'o' flag followed by a directory name gives the output
+		 * directory for batch mode.
+		 */
+		case 'o':
+			g.o = optarg;
+			break;
+		/*
+		 * "--stats=file" counts what the conversion does, and how
+		 *     long it takes, and writes it to the file as JSON.
+		 */
+		case 'S':
+			g.st = optarg;
+			opt.stats = 1;
+			break;
+		/*
+		 * "--mime" takes a whole MIME message, headers and all,
+		 *     and converts its text/enriched or text/richtext
+		 *     part.
+		 */
+		case 'M':
+			opt.mime = 1;
+			break;
+		case '?':
+			opterr++;
+			break;
+		}
+	if(opterr) {
+		showHelp();
+		rc = 1;
+	}
+
+	/*
+	 * any other arguments are input files, for batch mode. they need
+	 * somewhere to put the output.
+	 */
+	g.f = &argv[optind];
+	g.nf = argc - optind;
+	if (g.nf > 0 && g.o == NULL) {
+		fprintf(stderr, "%s: -o outdir is needed to convert files\n", g.n);
+		rc = 1;
+	}
+	if (g.nf > 0 && g.s != NULL) {
+		fprintf(stderr, "%s: files can't be converted in daemon mode\n", g.n);
+		rc = 1;
+	}
+	if (g.x != NULL && (g.nf > 0 || g.s != NULL)) {
+		fprintf(stderr, "%s: -x only splits standard input\n", g.n);
+		rc = 1;
+	}
+	if (g.x != NULL && opt.pdf) {
+		fprintf(stderr, "%s: -x only splits PostScript\n", g.n);
+		rc = 1;
+	}
+	if (g.st != NULL && (g.nf > 0 || g.s != NULL)) {
+		fprintf(stderr, "%s: --stats is only for standard input\n", g.n);
+		rc = 1;
+	}
+	if (g.nf == 0 && g.o != NULL) {
+		fprintf(stderr, "%s: -o given, but no files to convert\n", g.n);
+		rc = 1;
+	}
+	return(rc);
+}
+/*
+ * with -x, libenriched sink which keeps the PostScript in memory
+ */
+void
+memSink( void *arg, const char *buf, size_t len )
+{
+	char *p;
+	size_t max;
+
+	(void)arg;
+	if (mem.nomem)
+		return;
+	if (mem.max - mem.n < len) {
+		for (max = mem.max ? mem.max : 65536; max - mem.n < len; max *= 2)
+			;
+		if ((p = realloc(mem.buf, max)) == NULL) {
+			mem.nomem = 1;
+			return;
+		}
+		mem.buf = p;
+		mem.max = max;
+	}
+	memcpy(mem.buf + mem.n, buf, len);
+	mem.n += len;
+}
+/*
+ * with -x, write each page to a file of its own: the prolog and setup,
+ * the page, and a trailer. the page keeps its number in the document, in
+ * the file name and the label of its %%Page comment, and is the first of
+ * one.
+ *
+ * returns 0, or -1 if a file couldn't be written (the error has been
+ * reported).
+ */
+int
+splitPages( ENCTX *ctx )
+{
+	static char trailer[] = "%%Trailer\n%%Pages: 1\n%%EOF\n";
+	const size_t *off;
+	size_t n;
+	size_t i;
+	unsigned long label;
+	char *name;
+	char *p;
+	char *end;
+	FILE *fp;
+	int rc = 0;
+
+	if (mem.nomem) {
+		fprintf(stderr, "%s: out of memory\n", g.n);
+		return(-1);
+	}
+	n = enPages( ctx, &off );
+	if ((name = malloc(strlen(g.x) + 32)) == NULL) {
+		fprintf(stderr, "%s: out of memory\n", g.n);
+		return(-1);
+	}
+	for (i = 0; i < n && rc == 0; i++) {
+		p = mem.buf + off[i];
+		end = mem.buf + off[i + 1];
+		label = strtoul(p + sizeof("%%Page:") - 1, NULL, 10);
+		while (p < end && *p++ != '\n')
+			;
+		sprintf(name, "%s%lu.ps", g.x, label);
+		if ((fp = fopen(name, "w")) == NULL) {
+			perror(name);
+			rc = -1;
+			break;
+		}
+		fwrite(mem.buf, 1, off[0], fp);
+		fprintf(fp, "%%%%Page: %lu 1\n", label);
+		fwrite(p, 1, (size_t)(end - p), fp);
+		fwrite(trailer, 1, sizeof(trailer) - 1, fp);
+		if (ferror(fp) | fclose(fp)) {
+			perror(name);
+			rc = -1;
+		}
+	}
+	free(name);
+	return(rc);
+}
+/*
+ * with --stats, write what the conversion did to the file, as a JSON
+ * object. the keywords are the ones the converter knows, whether or not
+ * the document used them.
+ *
+ * returns 0, or -1 if the file couldn't be written (the error has been
+ * reported).
+ */
+int
+writeStats( ENCTX *ctx )
+{
+	static char *phase[] = { "prolog", "convert", "epilog" };
+	const struct enStats *st = enStats( ctx );
+	const char *k;
+	FILE *fp;
+	int i;
+
+	if ((fp = fopen(g.st, "w")) == NULL) {
+		perror(g.st);
+		return(-1);
+	}
+	fprintf(fp, "{\n  \"input_bytes\": %lu,\n  \"output_bytes\": %lu,\n",
+		(unsigned long) st->in, (unsigned long) st->out);
+	fprintf(fp, "  \"tokens_by_action\": [");
+	for (i = 0; i < EN_MAXACTION; i++)
+		fprintf(fp, "%s%lu", i ? ", " : "", (unsigned long) st->token[i]);
+	fprintf(fp, "],\n  \"shortcuts\": {\"S\": %lu, \"US\": %lu, "
+		"\"T\": %lu, \"UT\": %lu},\n",
+		(unsigned long) st->s, (unsigned long) st->us,
+		(unsigned long) st->t, (unsigned long) st->ut);
+	fprintf(fp, "  \"keywords\": {");
+	for (i = 0; i < EN_MAXKEY; i++)
+		if ((k = enKeyword( ctx, i )) != NULL)
+			fprintf(fp, "%s\n    \"%s\": {\"open\": %lu, \"close\": %lu}",
+				i ? "," : "", k, (unsigned long) st->keyOn[i],
+				(unsigned long) st->keyOff[i]);
+	fprintf(fp, "\n  },\n  \"unknown_tags\": %lu,\n",
+		(unsigned long) st->unknown);
+	fprintf(fp, "  \"font_changes\": %lu,\n  \"size_changes\": %lu,\n",
+		(unsigned long) st->fonts, (unsigned long) st->sizes);
+	fprintf(fp, "  \"NL\": %lu,\n  \"NP\": %lu,\n",
+		(unsigned long) st->nl, (unsigned long) st->np);
+	fprintf(fp, "  \"max_indent\": %d,\n  \"max_jstack\": %d,\n",
+		st->indent, st->jstack);
+	fprintf(fp, "  \"seconds\": {");
+	for (i = 0; i < 3; i++)
+		fprintf(fp, "%s\n    \"%s\": {\"wall\": %.6f, \"cpu\": %.6f}",
+			i ? "," : "", phase[i], st->wall[i], st->cpu[i]);
+	fprintf(fp, "\n  }\n}\n");
+	if (ferror(fp) | fclose(fp)) {
+		perror(g.st);
+		return(-1);
+	}
+	return(0);
+}
+/*
+ * get program name, for error messages
+ * simulate the "basename()" function, so as to avoid using libgen,
+ *   since not always available.
+ */
+char *
+baseName( char *n, char *a )
+{
+	extern char *strrchr( const char *, int);
+	n = strrchr(a, (int)'/');
+	if( n == NULL)
+		n = a;
+	else
+		++n;
+	return(n);
+}
+char *
+dirName( char *n, char *a )
+{
+	char *end;
+	extern char *strrchr( const char *, int);
+	end = strrchr(a, (int)'/');
+	if( end != NULL ) {
+		strncpy(n, a, (int)(end-a+1));
+		n[(int)(end-a+1)] = 0;
+	}
+	else
+		n[0] = 0;
+	return(n);
+}
+/*
+ * display some help text
+ */
+void
+showHelp()
+{
+	fprintf(stderr,"usage: %s [-b] [-p] [-t] [-h] [-l] [-w] [-c] [-m] [-k] [-z] [-g] [-P] [-r n-m] [-C charset] [-s nn] [--mime] [--stats=file] [-j n] [-d socket]\n",g.n);
+	fprintf(stderr,"       %s [-b] [-p] [-t] [-h] [-l] [-w] [-c] [-m] [-k] [-z] [-g] [-P] [-r n-m] [-C charset] [-s nn] [--mime] [-j n] -o outdir file ...\n",g.n);
+	fprintf(stderr,"       %s [-b] [-t] [-h] [-k] [-r n-m] [-C charset] [-s nn] [--mime] -x prefix\n",g.n);
+	fprintf(stderr,"       %s -i\n",g.n);
+	fprintf(stderr,"\nThe -b flag causes a box to be drawn along the page margins.\n");
+	fprintf(stderr,"\nThe -p flag suppresses output of the PostScript prolog code, an option probably only useful for debugging.\n");
+	fprintf(stderr,"\nThe -t flag changes the default font from Helvetica to Times-Roman.\n");
+	fprintf(stderr,"\nThe -h flag causes running headers to be printed on each page.\n");
+	fprintf(stderr,"\nThe -l flag lays out the lines in the program, rather than in the printer, which then only has to paint them.\n");
+	fprintf(stderr,"\nThe -w flag sends the words of a line to the printer in runs, rather than one by one, for smaller output which prints faster.\n");
+	fprintf(stderr,"\nThe -c flag sends words and spaces in a compact form, with the font only when it changes, for smaller output.\n");
+	fprintf(stderr,"\nThe -m flag leaves the fonts and macros the document doesn't use out of the prolog. The output comes at the end of the input.\n");
+	fprintf(stderr,"\nThe -k flag leaves the prolog out in favour of a reference to the one installed in the printer by the job the -i flag outputs. If it isn't installed, the output defines it for itself; with -kk, it doesn't, for the smallest output.\n");
+	fprintf(stderr,"\nThe -z flag compresses the output after the prolog, with LZW, which any PostScript Level 2 printer can decode; with -zz, with Flate, which is smaller but needs Level 3. It makes no difference with -g, -r or -P.\n");
+	fprintf(stderr,"\nThe -g flag lays out the lines as -l does, and makes every page stand alone, with the structure comments of the Document Structuring Conventions. The trailer gives the offset of each page in the output.\n");
+	fprintf(stderr,"\nThe -r flag outputs only the pages in a range, \"3-4\", \"3-\", \"-4\" or \"3\", each standing alone as with -g.\n");
+	fprintf(stderr,"\nThe --stats=file option writes counts of what the conversion did (tokens, keywords, line and page breaks) and the time each phase took to the file, as JSON.\n");
+	fprintf(stderr,"\nThe -P flag writes PDF instead of PostScript, laid out as with -l. In batch mode the output files are named .pdf.\n");
+	fprintf(stderr,"\nThe -x flag writes each page to a file of its own, \"prefix1.ps\", \"prefix2.ps\" and so on, which can be printed separately.\n");
+	fprintf(stderr,"\nThe -C flag gives the character set of the input: utf-8, iso-8859-1 to iso-8859-16 or windows-1252. It is converted to ISO-8859-1, which the fonts are encoded in, with the nearest character, or \"?\", for those it doesn't have.\n");
+	fprintf(stderr,"\nThe --mime option reads a whole mail message, headers and all, and converts its first text/enriched or text/richtext part, decoding quoted-printable or base64, in the character set its Content-Type gives.\n");
+	fprintf(stderr,"\nThe -s flag changes the default font size from 10 pt to the value of \"nn\", up to a maximum of 36 pt.\n");
+	fprintf(stderr,"\nThe -d flag runs the program as a daemon, converting jobs sent to the Unix domain socket \"socket\". See server.h for the protocol.\n");
+	fprintf(stderr,"\nGiven files, the program converts each one into the directory \"outdir\", with its suffix replaced by .ps. The -j flag converts \"n\" files at once, up to %d, or one per processor for -j 0.\n", MAXJOBS);
+	fprintf(stderr,"\nGiven standard input, the -j flag converts it on \"n\" threads, or one per processor for -j 0, with the same output. Lines laid out by the program (-l, -g, -r, -P) and --mime are converted on one.\n");
+	fprintf(stderr,"\nThe -u flag causes unrecognized MIME tags to be shown in the output.\n");
+}
@@ -0,0 +1,118 @@
+/*
+ * Name: input.c
+ *
+ * Function: block-buffered input for the rt2ps and et2ps filters.
+ *	See input.h for a description.
+ */
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "input.h"
+
+static int inMap( struct input *, int, struct stat * );
+static int inRead( struct input *, int );
+
+/*
+ * make the data on file descriptor "fd" available in a buffer. a regular
+ * file is mapped into memory, anything else (pipe, terminal, socket) is
+ * read in large blocks until end of file.
+ *
+ * returns 0 on success, -1 on failure with errno set.
+ */
+int
+inOpen( struct input *in, int fd )
+{
+	struct stat st;
+
+	memset(in, 0, sizeof(*in));
+	if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+		if (inMap(in, fd, &st) == 0)
+			return(0);
+	}
+	return(inRead(in, fd));
+}
+/*
+ * map a regular file. the file may already have been partly read by
+ * someone else, e.g. "(read line; rt2ps) < file", so the cursor starts
+ * at the current file offset, not at the start of the file.
+ */
+static int
+inMap( struct input *in, int fd, struct stat *st )
+{
+	off_t off;
+	void *p;
+
+	if ((off = lseek(fd, (off_t)0, SEEK_CUR)) < 0)
+		return(-1);
+	p = mmap(NULL, (size_t)st->st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (p == MAP_FAILED)
+		return(-1);
+#ifdef MADV_SEQUENTIAL
+	(void) madvise(p, (size_t)st->st_size, MADV_SEQUENTIAL);
+#endif
+	in->base = (char *) p;
+	in->size = (size_t)st->st_size;
+	in->cur = in->base + ((off < st->st_size) ? off : st->st_size);
+	in->end = in->base + st->st_size;
+	in->mapped = 1;
+	return(0);
+}
+/*
+ * read everything from a non-seekable descriptor into a malloc()ed
+ * buffer, doubling the buffer each time it fills up.
+ */
+static int
+inRead( struct input *in, int fd )
+{
+	size_t len = 0;
+	ssize_t n;
+	char *p;
+
+	in->size = INBLOCK;
+	if ((in->base = malloc(in->size)) == NULL)
+		return(-1);
+	for (;;) {
+		if (len == in->size) {
+			if ((p = realloc(in->base, in->size * 2)) == NULL) {
+				free(in->base);
+				in->base = NULL;
+				return(-1);
+			}
+			in->base = p;
+			in->size *= 2;
+		}
+		n = read(fd, in->base + len, in->size - len);
+		if (n < 0) {
+			if (errno == EINTR)
+				continue;
+			free(in->base);
+			in->base = NULL;
+			return(-1);
+		}
+		if (n == 0)
+			break;
+		len += (size_t) n;
+	}
+	in->cur = in->base;
+	in->end = in->base + len;
+	in->mapped = 0;
+	return(0);
+}
+/*
+ * release the input buffer
+ */
+void
+inClose( struct input *in )
+{
+	if (in->base != NULL) {
+		if (in->mapped)
+			(void) munmap(in->base, in->size);
+		else
+			free(in->base);
+	}
+	memset(in, 0, sizeof(*in));
+}
@@ -0,0 +1,47 @@
+/*
+ * Name: input.h
+ *
+ * Function: block-buffered input for the rt2ps and et2ps filters.
+ *
+ *	Rather than pulling one character at a time from standard input
+ *	with getchar(), the whole input stream is made available in a
+ *	single buffer. If standard input is a regular file it is mapped
+ *	into memory, otherwise it is read in large blocks. The tokenizer
+ *	then walks a cursor over the buffer, and lookahead is just a peek
+ *	at the character under the cursor.
+ */
+#ifndef INPUT_H
+#define INPUT_H
+
+#include <stdio.h>
+#include <sys/types.h>
+
+/*
+ * size of the first block read from a pipe or terminal. the buffer
+ * is doubled each time it fills up.
+ */
+#define INBLOCK 65536
+
+struct input {
+	char *base;		/* start of the input buffer */
+	char *cur;		/* cursor: next character to be read */
+	char *end;		/* one past the last character in the buffer */
+	size_t size;		/* size of the mapped or allocated area */
+	int mapped;		/* flag: buffer is mmap()ed, not malloc()ed */
+};
+
+/*
+ * get the next character and advance the cursor, or look at the next
+ * character without advancing. both return EOF at the end of the input,
+ * and otherwise return the character as an unsigned char, the same as
+ * getchar() does.
+ */
+#define inGet(p)	((p)->cur < (p)->end ? \
+				(int)(unsigned char) *(p)->cur++ : EOF)
+#define inPeek(p)	((p)->cur < (p)->end ? \
+				(int)(unsigned char) *(p)->cur : EOF)
+
+int  inOpen( struct input *, int );
+void inClose( struct input * );
+
+#endif /* INPUT_H */
@@ -0,0 +1,743 @@
+/*
+ * Name: layout.c
+ *
+ * Function: libenriched host layout, the -l flag of rt2ps and et2ps.
+ *
+ *	Normally the printer lays out the text: for every token the
+ *	prolog's pass 1 (C, SH1, SP1, TB1, LE) calls stringwidth and keeps
+ *	the token on the operand stack, and at the end of each line pass 2
+ *	(NL, SNL, C2) rolls the tokens back out and shows them one by one.
+ *	In this mode the converter does both passes itself, with the
+ *	character widths of the twelve fonts built in (afm.h, made by
+ *	mkafm), and the output is just the finished lines: a moveto, and a
+ *	show (or a widthshow, for full justification) for each run of text
+ *	in one font.
+ *
+ *	The layout is a copy of the one in paginate.ps.verbose, procedure
+ *	by procedure, so that a document looks the same either way. The
+ *	variables have the names of the PostScript ones, in lower case.
+ *	That includes the oddities: a tab which runs past the right margin
+ *	still counts in the length of the line it ends, TRUNC takes the
+ *	width of a space divided by the width of the trailing spaces off
+ *	the space count, and the font a token is measured or shown in is
+ *	whatever was set last, by either pass.
+ *
+ *	With the -g flag, the pages follow the Document Structuring
+ *	Conventions: each one starts with a %%Page comment and sets up
+ *	everything it depends on, the font, the page number, the box and
+ *	the header, inside a save and restore of its own. So any page can
+ *	be printed without the ones before it, and the trailer lists
+ *	where each one starts in the output.
+ *
+ *	With -r, the pages are laid out as with -g, but only the ones in
+ *	the range are output; the others are laid out and dropped. Since
+ *	every page sets itself up, nothing of the pages before the range
+ *	is needed to print it.
+ *
+ *	With -P, the pages are laid out as with -g, and the drawing
+ *	operations go to pdf.c instead of being written as PostScript.
+ *
+ * Data Format: see engine.c.
+ */
+#include <stdlib.h>
+#include <string.h>
+#include "enpriv.h"
+#include "afm.h"
+
+static int    push( ENCTX *, const char *, size_t, int, int, double );
+static void   setFont( struct layout *, int, int );
+static double width( struct layout *, const char *, size_t );
+static int    spaces( const char *, size_t );
+static void   newLine( ENCTX * );
+static void   softNewline( ENCTX * );
+static void   lineStart( ENCTX * );
+static void   newPage( ENCTX * );
+static void   pageOpen( ENCTX * );
+static void   pageClose( ENCTX * );
+static int    pageMark( ENCTX * );
+static void   paint( ENCTX * );
+static void   paintText( ENCTX *, size_t, size_t, int );
+static void   paintFont( ENCTX * );
+
+/*
+ * set up the layout of a new document
+ */
+void
+layOpen( ENCTX *g )
+{
+	struct layout *l = &g->lay;
+
+	l->lm = l->nlm = X_LEFT;
+	l->rm = l->nrm = X_RIGHT;
+	l->x = X_LEFT;
+	l->y = Y_TOP;
+	l->times = g->altFont;
+	l->font = l->pfont = -1;
+}
+/*
+ * free the line buffers
+ */
+void
+layClose( ENCTX *g )
+{
+	free(g->lay.item);
+	free(g->lay.text);
+	free(g->lay.page);
+}
+/*
+ * a token, as tokenOutput() would send to the C macro. "s" is the string,
+ * as it is in the input, "mask" the font attributes, or -1 for the
+ * "don't care" font x.
+ *
+ * this is pass 1: SH1, SP1, TB1 and B1.
+ */
+void
+layToken( ENCTX *g, const char *s, size_t len, int size, int mask, int action )
+{
+	struct layout *l = &g->lay;
+	int font = -1;
+	double w;
+	double sw;
+	double nx;
+
+	if (g->error)
+		return;
+	if (mask >= 0) {
+		font = (mask & FIXED) ? 8 : (l->times ? 4 : 0);
+		font += mask & (BOLD|ITALIC);
+		setFont(l, font, size);
+	}
+	switch (action) {
+	/*
+	 * space(s): the line ends before them if they don't fit
+	 */
+	case 2:
+	case 3:
+		w = width(l, s, len);
+		l->x += w;
+		sw = width(l, " ", 1);
+		if (l->x > l->rm) {
+			l->x -= w;
+			l->rem = 0;
+			newLine(g);
+		}
+		else if (push(g, s, len, font, action, w) == 0)
+			l->sc += (sw != 0) ? (long)(w / sw) : 0;
+		break;
+	/*
+	 * tab: to the next 1 inch boundary
+	 */
+	case 4:
+	case 5:
+		nx = (long)((l->x + 72) / 72) * 72;
+		w = nx - l->x;
+		l->x = nx;
+		if (l->x > l->rm) {
+			l->rem = 0;
+			newLine(g);
+		}
+		else
+			(void) push(g, s, len, font, action, w);
+		break;
+	/*
+	 * a string, or a subscript or superscript: no wider than a line
+	 * (LE). one which doesn't fit starts the next line.
+	 */
+	default:
+		w = width(l, s, len);
+		if (w > l->rm - l->lm)
+			w = l->rm - l->lm;
+		if (push(g, s, len, font, action, w) != 0)
+			return;
+		l->rem = w;
+		if (l->x + w > l->rm)
+			softNewline(g);
+		else
+			l->x += w;
+		break;
+	}
+}
+/*
+ * one of the operators for a line or the page: NL, NP, or a margin change
+ */
+void
+layOp( ENCTX *g, int op )
+{
+	struct layout *l = &g->lay;
+
+	if (g->error)
+		return;
+	switch (op) {
+	case LAY_NL:
+		newLine(g);
+		break;
+	case LAY_NP:
+		newLine(g);
+		if (l->x != l->lm || l->y != Y_TOP) {
+			newPage(g);
+			l->x = l->lm;
+			l->y = Y_TOP;
+		}
+		break;
+	case LAY_ILM:
+		l->lm += INDENT;
+		l->nlm = l->lm;
+		l->x += INDENT;
+		break;
+	case LAY_DLM:
+		l->lm -= INDENT;
+		l->nlm = l->lm;
+		l->x -= INDENT;
+		break;
+	case LAY_DILM:
+		l->nlm += INDENT;
+		break;
+	case LAY_DDLM:
+		l->nlm -= INDENT;
+		break;
+	case LAY_IRM:
+		l->rm -= INDENT;
+		l->nrm = l->rm;
+		break;
+	case LAY_DRM:
+		l->rm += INDENT;
+		l->nrm = l->rm;
+		break;
+	case LAY_DIRM:
+		l->nrm -= INDENT;
+		break;
+	case LAY_DDRM:
+		l->nrm += INDENT;
+		break;
+	}
+}
+/*
+ * a change of justification, the JU variable
+ */
+void
+layJustify( ENCTX *g, int ju )
+{
+	g->lay.ju = ju;
+}
+/*
+ * the main font family changes to Times (times = true) or Helvetica
+ */
+void
+layFamily( ENCTX *g, int times )
+{
+	g->lay.times = times;
+}
+/*
+ * end of the document: the last line, and the final showpage without a
+ * box or header. with -g, a page is only started when a line goes on
+ * it, so the box and header can stay, and the trailer follows.
+ */
+void
+layFinish( ENCTX *g )
+{
+	struct layout *l = &g->lay;
+	size_t i;
+
+	if (!g->pages) {
+		g->box = 0;
+		g->hdr = 0;
+	}
+	layOp(g, LAY_NP);
+	if (g->pdfOut && !g->error) {
+		pdfFinish(g);
+		return;
+	}
+	if (!g->pages || g->error || pageMark(g) != 0)
+		return;
+	outLit(&g->out, "%%Trailer\n%%Pages: ");
+	outSize(&g->out, l->npage);
+	outChar(&g->out, '\n');
+	for (i = 0; i < l->npage; i++) {
+		outLit(&g->out, "%PageOffset: ");
+		outSize(&g->out, i + 1);
+		outChar(&g->out, ' ');
+		outSize(&g->out, l->page[i]);
+		outChar(&g->out, '\n');
+	}
+	outLit(&g->out, "%TrailerOffset: ");
+	outSize(&g->out, l->page[l->npage]);
+	outChar(&g->out, '\n');
+}
+/*
+ * add a token to the line. returns 0, or -1 if there's no memory.
+ */
+static int
+push( ENCTX *g, const char *s, size_t len, int font, int action, double w )
+{
+	struct layout *l = &g->lay;
+	struct layItem *t;
+	void *p;
+	size_t max;
+
+	if (l->n == l->max) {
+		max = l->max ? 2 * l->max : 64;
+		if ((p = realloc(l->item, max * sizeof(*l->item))) == NULL) {
+			enFatal(g, "Out of memory");
+			return(-1);
+		}
+		l->item = p;
+		l->max = (int) max;
+	}
+	if (l->tmax - l->tn < len) {
+		for (max = l->tmax ? l->tmax : BUFFSIZE; max - l->tn < len; max *= 2)
+			;
+		if ((p = realloc(l->text, max)) == NULL) {
+			enFatal(g, "Out of memory");
+			return(-1);
+		}
+		l->text = p;
+		l->tmax = max;
+	}
+	t = &l->item[l->n++];
+	t->action = action;
+	t->font = font;
+	t->size = l->size;
+	t->w = w;
+	t->text = l->tn;
+	t->len = len;
+	if (len > 0)
+		memcpy(l->text + l->tn, s, len);
+	l->tn += len;
+	return(0);
+}
+/*
+ * change fonts and keep track of the font height, F and FFH
+ */
+static void
+setFont( struct layout *l, int font, int size )
+{
+	l->font = font;
+	l->size = size;
+	l->fh = size;
+	if (size > l->mfh)
+		l->mfh = size;
+}
+/*
+ * the length of a string in the current font, stringwidth
+ */
+static double
+width( struct layout *l, const char *s, size_t len )
+{
+	if (l->font < 0)
+		return(0);
+	return(layWidth(l->font, l->size, s, len));
+}
+/*
+ * the length of a string in font "font" (as numbered in afm.h) at "size"
+ * points
+ */
+double
+layWidth( int font, int size, const char *s, size_t len )
+{
+	const unsigned short *w;
+	const char *end = s + len;
+	long n = 0;
+
+	w = afmWidth[font];
+	for ( ; s < end; s++)
+		n += w[(unsigned char) *s];
+	return((double) n * size / 1000);
+}
+/*
+ * the number of space characters in a string
+ */
+static int
+spaces( const char *s, size_t len )
+{
+	int n = 0;
+
+	while (len-- > 0)
+		if (*s++ == ' ')
+			n++;
+	return(n);
+}
+/*
+ * hard newline, NL: show the line, and start the next one at the
+ * (possibly new) left margin
+ */
+static void
+newLine( ENCTX *g )
+{
+	struct layout *l = &g->lay;
+
+	lineStart(g);
+	paint(g);
+	l->n = 0;
+	l->tn = 0;
+	l->lm = l->nlm;
+	l->x = l->lm;
+	l->rem = 0;
+	l->sc = 0;
+	l->rm = l->nrm;
+}
+/*
+ * soft newline, SNL: the last token crossed the right margin, so the
+ * line is shown without it, and it starts the next line
+ */
+static void
+softNewline( ENCTX *g )
+{
+	struct layout *l = &g->lay;
+	struct layItem r;
+
+	r = l->item[--l->n];
+	lineStart(g);
+	paint(g);
+	if (r.len > 0)
+		memmove(l->text, l->text + r.text, r.len);
+	r.text = 0;
+	l->item[0] = r;
+	l->n = 1;
+	l->tn = r.len;
+	l->lm = l->nlm;
+	l->x = l->rem + l->lm;
+	l->rem = 0;
+	l->sc = 0;
+	l->rm = l->nrm;
+}
+/*
+ * find where the line starts, LS: the length of the line less any
+ * trailing space (LEN, TRUNC), the X coordinate for the justification
+ * (SX, SXCJ, SXRJ, SXFJ) and the Y coordinate, which may be on a new
+ * page (SY)
+ */
+static void
+lineStart( ENCTX *g )
+{
+	struct layout *l = &g->lay;
+	struct layItem *t;
+	double w;
+
+	l->l = l->x - l->lm;
+	if (l->n > 0) {
+		t = &l->item[l->n - 1];
+		if (t->action == 2 || t->action == 3) {
+			l->l -= t->w;
+			l->n--;
+			l->tn = t->text;
+			if (t->w != 0)
+				l->sc -= width(l, " ", 1) / t->w;
+		}
+	}
+
+	switch (l->ju) {
+	case 0:
+		l->x = l->lm;
+		break;
+	case 1:
+		l->x = (l->rm - l->lm) / 2 - l->l / 2 + l->lm;
+		break;
+	case 2:
+		l->x = l->rm - l->l;
+		break;
+	default:
+		/*
+		 * full justification pads the spaces, unless the line is
+		 * less than 3/4 of the width between the margins
+		 */
+		l->x = l->lm;
+		l->adj = 0;
+		if (l->sc > 0) {
+			w = l->rm - l->lm;
+			if (!(w / 4 * 3 > l->l))
+				l->adj = (w - l->l) / l->sc;
+		}
+		break;
+	}
+
+	l->y -= l->mfh;
+	if (l->y < Y_BOT) {
+		newPage(g);
+		l->y = Y_TOP - l->mfh;
+	}
+	l->mfh = l->fh;
+	if (g->pages && !l->open)
+		pageOpen(g);
+}
+/*
+ * page eject, and the box and running header for the next page. with
+ * -g, the next page is started by the first line on it instead.
+ */
+static void
+newPage( ENCTX *g )
+{
+	if (g->pages) {
+		if (!g->lay.open)
+			pageOpen(g);
+		pageClose(g);
+		return;
+	}
+	outLit(&g->out, "showpage\n");
+	if (g->box)
+		outLit(&g->out, "DB\n");
+	if (g->hdr)
+		outLit(&g->out, "PH\n");
+}
+/*
+ * with -g, start a page: its %%Page comment, and the box, header and
+ * page number, as the setup does for the first page without -g. the
+ * font is set again for its first line. a page outside the range of -r
+ * is laid out, but nothing of it goes out.
+ */
+static void
+pageOpen( ENCTX *g )
+{
+	struct layout *l = &g->lay;
+
+	l->pageno++;
+	l->open = 1;
+	l->skip = (g->from > 0 && l->pageno < (size_t)g->from) ||
+		  (g->to > 0 && l->pageno > (size_t)g->to);
+	if (l->skip)
+		return;
+	if (g->pdfOut) {
+		l->npage++;
+		pdfPageOpen(g);
+		l->pfont = -1;
+		return;
+	}
+	if (pageMark(g) != 0)
+		return;
+	l->npage++;
+	outLit(&g->out, "%%Page: ");
+	outSize(&g->out, l->pageno);
+	outChar(&g->out, ' ');
+	outSize(&g->out, l->npage);
+	outLit(&g->out, "\n%%BeginPageSetup\n/PGSV save def\n");
+	if (g->box)
+		outLit(&g->out, "DB\n");
+	if (g->hdr) {
+		outLit(&g->out, "/PG ");
+		outSize(&g->out, l->pageno);
+		outLit(&g->out, " def\nPH\n");
+	}
+	outLit(&g->out, "%%EndPageSetup\n");
+	l->pfont = -1;
+}
+/*
+ * with -g, the end of a page
+ */
+static void
+pageClose( ENCTX *g )
+{
+	if (!g->lay.skip) {
+		if (g->pdfOut)
+			pdfPageClose(g);
+		else
+			outLit(&g->out, "showpage\nPGSV restore\n");
+	}
+	g->lay.open = 0;
+}
+/*
+ * with -g, note where the next page, or the trailer, starts in the
+ * output. returns 0, or -1 if there's no memory.
+ */
+static int
+pageMark( ENCTX *g )
+{
+	struct layout *l = &g->lay;
+	void *p;
+	size_t max;
+
+	if (l->npage == l->maxpage) {
+		max = l->maxpage ? 2 * l->maxpage : 64;
+		if ((p = realloc(l->page, max * sizeof(*l->page))) == NULL) {
+			enFatal(g, "Out of memory");
+			return(-1);
+		}
+		l->page = p;
+		l->maxpage = max;
+	}
+	l->page[l->npage] = outPos(&g->out);
+	return(0);
+}
+/*
+ * pass 2, C2: show the tokens on the line, starting at X,Y. consecutive
+ * words and spaces in the same font are shown with one operator. with
+ * -P, each operation goes to pdf.c instead.
+ */
+static void
+paint( ENCTX *g )
+{
+	struct layout *l = &g->lay;
+	struct layItem *t;
+	struct layItem *end = l->item + l->n;
+	size_t run = 0;		/* start of the text not yet shown */
+	size_t next = 0;	/* and its end */
+	double w;
+
+	if (l->n == 0 || l->skip)
+		return;
+	if (g->pdfOut)
+		pdfMove(g, l->x, l->y);
+	else {
+		outReal(&g->out, l->x);
+		outChar(&g->out, ' ');
+		outReal(&g->out, l->y);
+		outLit(&g->out, " moveto\n");
+	}
+	for (t = l->item; t < end; t++) {
+		if (t->font >= 0) {
+			l->font = t->font;
+			l->size = t->size;
+		}
+
+		/*
+		 * tabs don't need a font
+		 */
+		if (t->action == 4 || t->action == 5) {
+			paintText(g, run, next, 1);
+			run = next = t->text + t->len;
+			if (g->pdfOut) {
+				if (t->action == 5)
+					pdfLine(g, t->w);
+				pdfRMove(g, t->w, 0);
+				continue;
+			}
+			if (t->action == 5) {
+				outReal(&g->out, t->w);
+				outLit(&g->out, " UL ");
+			}
+			outReal(&g->out, t->w);
+			outLit(&g->out, " 0 rmoveto\n");
+			continue;
+		}
+		if (l->font < 0) {
+			run = next = t->text + t->len;
+			continue;
+		}
+		if (l->font != l->pfont || l->size != l->psize) {
+			paintText(g, run, next, 1);
+			run = next = t->text;
+			paintFont(g);
+		}
+		if (t->action == 0 || t->action == 2) {
+			next = t->text + t->len;
+			continue;
+		}
+
+		/*
+		 * underlined, subscript or superscript
+		 */
+		paintText(g, run, next, 1);
+		w = -1;
+		switch (t->action) {
+		case 1:
+		case 7:
+		case 9:
+			w = t->w;
+			break;
+		case 3:
+			w = width(l, l->text + t->text, t->len);
+			if (l->ju == 3)
+				w += l->adj * spaces(l->text + t->text, t->len);
+			break;
+		}
+		if (g->pdfOut) {
+			if (w >= 0)
+				pdfLine(g, w);
+			pdfRMove(g, 0, t->action == 6 || t->action == 7 ? -2 :
+				 t->action == 8 || t->action == 9 ? t->size : 0);
+			paintText(g, t->text, t->text + t->len, t->action == 3);
+			pdfMove(g, g->pdf.x, l->y);
+			run = next = t->text + t->len;
+			continue;
+		}
+		if (w >= 0) {
+			outReal(&g->out, w);
+			outLit(&g->out, " UL ");
+		}
+		switch (t->action) {
+		case 6:
+		case 7:
+			outLit(&g->out, "0 -2 rmoveto ");
+			break;
+		case 8:
+		case 9:
+			outLit(&g->out, "0 ");
+			outInt(&g->out, t->size);
+			outLit(&g->out, " rmoveto ");
+			break;
+		}
+		paintText(g, t->text, t->text + t->len, t->action == 3);
+		switch (t->action) {
+		case 6:
+		case 7:
+			outLit(&g->out, "0 2 rmoveto\n");
+			break;
+		case 8:
+		case 9:
+			outLit(&g->out, "0 ");
+			outInt(&g->out, -t->size);
+			outLit(&g->out, " rmoveto\n");
+			break;
+		}
+		run = next = t->text + t->len;
+	}
+	paintText(g, run, next, 1);
+}
+/*
+ * show the text from "run" to "next" in the text buffer, if any. "pad" is
+ * set if it's words and spaces, whose spaces are padded for full
+ * justification. a subscript or superscript is shown as it is, spaces
+ * and all.
+ */
+static void
+paintText( ENCTX *g, size_t run, size_t next, int pad )
+{
+	struct layout *l = &g->lay;
+	const char *s = l->text + run;
+	size_t len = next - run;
+	double w;
+
+	if (len == 0)
+		return;
+	if (g->pdfOut) {
+		/*
+		 * the current point moves by the width in the font last
+		 * set, which is the one the string is shown in
+		 */
+		w = layWidth(l->pfont, l->psize, s, len);
+		if (pad && l->ju == 3)
+			pdfText(g, s, len, l->adj, w + l->adj * spaces(s, len));
+		else
+			pdfText(g, s, len, 0, w);
+		return;
+	}
+	if (pad && l->ju == 3 && l->adj != 0 && memchr(s, ' ', len) != NULL) {
+		outReal(&g->out, l->adj);
+		outLit(&g->out, " 0 32 (");
+		outEsc(&g->out, s, len);
+		outLit(&g->out, ") widthshow\n");
+	}
+	else {
+		outChar(&g->out, '(');
+		outEsc(&g->out, s, len);
+		outLit(&g->out, ") show\n");
+	}
+}
+/*
+ * set the current font in the output, F2
+ */
+static void
+paintFont( ENCTX *g )
+{
+	struct layout *l = &g->lay;
+
+	if (g->pdfOut)
+		pdfFont(g, l->font, l->size);
+	else {
+		outInt(&g->out, l->size);
+		outLit(&g->out, " /");
+		outStr(&g->out, afmName[l->font]);
+		outLit(&g->out, " F2\n");
+	}
+	g->uses |= PS_FONT(l->font);
+	l->pfont = l->font;
+	l->psize = l->size;
+}
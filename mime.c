@@ -0,0 +1,655 @@
+/*
+ * Name: mime.c
+ *
+ * Function: libenriched MIME message front end, the --mime flag of rt2ps
+ *	and et2ps.
+ *
+ *	With --mime, the input is a whole RFC 822 message, as it arrives
+ *	from the mail system, rather than the body of a text/richtext or
+ *	text/enriched part. It is walked here in one pass as it's fed in:
+ *	the headers of each entity are read for its Content-Type and
+ *	Content-Transfer-Encoding, multipart bodies are split at their
+ *	boundaries (nested ones too), and a message/rfc822 part is walked
+ *	in turn. The first text/enriched or text/richtext part found is
+ *	decoded (quoted-printable and base64 a byte at a time, anything
+ *	else as it is) and goes to the converter for its dialect, whichever
+ *	program is running; its charset parameter, if it's one charset.c
+ *	knows, takes the place of -C. Everything else is skipped, so of a
+ *	multipart/alternative, the text/plain version before the enriched
+ *	one is passed over, and the rest of the message after the part is
+ *	ignored.
+ *
+ *	Nothing is kept but a header field at a time, and the start of a
+ *	line which may be a boundary. The rest of a line goes straight on
+ *	from the caller's block, or from a small buffer when it's decoded.
+ *	The line break before a boundary belongs to the boundary, so the
+ *	one at the end of each line of the part is held back until the
+ *	next line turns out not to be one.
+ *
+ * Data Format: RFC 822 (RFC 2822) messages, with the MIME structure of
+ *	RFC 2045 and RFC 2046. See engine.c for the parts converted.
+ */
+#include <string.h>
+#include "enpriv.h"
+
+/* where the message is being walked, state */
+#define M_HEAD 0		/* the header fields of an entity */
+#define M_BODY 1		/* its body */
+
+/* where in a line, line */
+#define L_START 0		/* at the start, which may be a boundary */
+#define L_MID 1			/* past it, in the line */
+#define L_DELIM 2		/* the rest of a boundary line */
+
+/* what an entity is, type and body */
+#define MT_SKIP 0		/* not wanted */
+#define MT_TEXT 1		/* text/enriched or text/richtext */
+#define MT_MULTI 2		/* multipart, with a boundary */
+#define MT_MESSAGE 3		/* message/rfc822 */
+
+/* its Content-Transfer-Encoding, enc */
+#define TE_NONE 0		/* 7bit, 8bit or binary */
+#define TE_QP 1			/* quoted-printable */
+#define TE_B64 2		/* base64 */
+
+#define MIMEBUF 4096		/* decoded input is collected here */
+
+static int  scan( ENCTX *, const char *, size_t );
+static int  content( ENCTX *, const char *, size_t );
+static int  lineEnd( ENCTX * );
+static int  match( struct mime * );
+static int  delimiter( ENCTX *, int, int );
+static void headStart( struct mime *, int );
+static void field( struct mime * );
+static void contentType( struct mime *, const char * );
+static const char *token( const char *, char *, size_t );
+static const char *skipSpace( const char * );
+static void bodyStart( ENCTX * );
+static int  decode( ENCTX *, const char *, size_t );
+static int  decodeEnd( ENCTX * );
+static int  pass( ENCTX *, const char *, size_t );
+static int  next( ENCTX *, const char *, size_t );
+
+/*
+ * walk a block of the message
+ */
+int
+mimeFeed( ENCTX *g, const char *s, size_t len )
+{
+	if (g->msg.done)
+		return(0);
+	return(scan(g, s, len));
+}
+/*
+ * end of the message: the end of the part being converted, or an error
+ * if there wasn't one
+ */
+int
+mimeFlush( ENCTX *g )
+{
+	struct mime *m = &g->msg;
+
+	if (!m->done) {
+		if (m->line == L_DELIM && delimiter(g, m->level, m->close) != 0)
+			return(-1);
+		if (m->ln > 0 && content(g, m->lb, m->ln) != 0)
+			return(-1);
+		m->ln = 0;
+		if (m->held && m->body == MT_TEXT && m->state == M_BODY &&
+		    decode(g, "\n", 1) != 0)
+			return(-1);
+		if (m->body == MT_TEXT && m->state == M_BODY &&
+		    decodeEnd(g) != 0)
+			return(-1);
+	}
+	if (!m->found) {
+		enFatal(g, "No text/enriched or text/richtext part");
+		return(-1);
+	}
+	return(0);
+}
+/*
+ * split a block into lines, looking for boundaries at their start
+ */
+static int
+scan( ENCTX *g, const char *s, size_t len )
+{
+	struct mime *m = &g->msg;
+	const char *p = s, *end = s + len, *q;
+	int i, c;
+
+	while (p < end && !m->done)
+		switch (m->line) {
+		case L_START:
+			c = (unsigned char) *p;
+			if (m->ln == 0 && (m->nb == 0 || c != '-')) {
+				m->line = L_MID;
+				break;
+			}
+			p++;
+			if (c == '\n') {
+				if (content(g, m->lb, m->ln) != 0 ||
+				    lineEnd(g) != 0)
+					return(-1);
+				m->ln = 0;
+				break;
+			}
+			m->lb[m->ln++] = (char) c;
+			if ((i = match(m)) == -1) {
+				if (content(g, m->lb, m->ln) != 0)
+					return(-1);
+				m->ln = 0;
+				m->line = L_MID;
+			}
+			else if (i >= 0) {
+				m->ln = 0;
+				m->level = i;
+				m->close = 0;
+				m->dn = 0;
+				m->line = L_DELIM;
+			}
+			break;
+		case L_MID:
+			if ((q = memchr(p, '\n', (size_t)(end - p))) == NULL) {
+				if (content(g, p, (size_t)(end - p)) != 0)
+					return(-1);
+				p = end;
+				break;
+			}
+			if (content(g, p, (size_t)(q - p)) != 0 ||
+			    lineEnd(g) != 0)
+				return(-1);
+			p = q + 1;
+			m->line = L_START;
+			break;
+		case L_DELIM:
+			/*
+			 * "--" straight after the boundary closes the
+			 * multipart. the rest of the line is padding.
+			 */
+			c = (unsigned char) *p++;
+			if (c == '\n') {
+				m->line = L_START;
+				if (delimiter(g, m->level, m->close) != 0)
+					return(-1);
+				break;
+			}
+			if (m->dn < 2 && c == '-' && ++m->dn == 2)
+				m->close = 1;
+			else
+				m->dn = 2;
+			break;
+		}
+	return(0);
+}
+/*
+ * some of a line, not the line break
+ */
+static int
+content( ENCTX *g, const char *s, size_t n )
+{
+	struct mime *m = &g->msg;
+	size_t i;
+	int c;
+
+	if (n == 0)
+		return(0);
+	if (m->state == M_BODY) {
+		if (m->body != MT_TEXT)
+			return(0);
+		if (m->held) {
+			m->held = 0;
+			if (decode(g, "\n", 1) != 0)
+				return(-1);
+		}
+		return(decode(g, s, n));
+	}
+
+	/*
+	 * a header field goes on while the lines after it start with
+	 * white space. what won't fit is left out.
+	 */
+	for (i = 0; i < n; i++) {
+		if ((c = (unsigned char) s[i]) == '\r')
+			continue;
+		if (m->hend) {
+			m->hend = 0;
+			if (c != ' ' && c != '\t') {
+				field(m);
+				m->hn = 0;
+			}
+		}
+		if (m->hn < sizeof(m->hdr) - 1)
+			m->hdr[m->hn++] = (char) c;
+		m->hline = 1;
+	}
+	return(0);
+}
+/*
+ * the end of a line. an empty one ends the header fields.
+ */
+static int
+lineEnd( ENCTX *g )
+{
+	struct mime *m = &g->msg;
+
+	if (m->state == M_BODY) {
+		if (m->body != MT_TEXT)
+			return(0);
+		if (m->held && decode(g, "\n", 1) != 0)
+			return(-1);
+		m->held = 1;
+		return(0);
+	}
+	if (m->hline) {
+		m->hend = 1;
+		m->hline = 0;
+		return(0);
+	}
+	if (m->hend)
+		field(m);
+	bodyStart(g);
+	return(0);
+}
+/*
+ * is the start of the line a boundary of one of the multiparts? returns
+ * the multipart's level if it is, -2 if it may be, and -1 if it isn't
+ */
+static int
+match( struct mime *m )
+{
+	int i, r = -1;
+
+	for (i = m->nb - 1; i >= 0; i--)
+		if (m->ln <= m->bl[i] && memcmp(m->lb, m->bnd[i], m->ln) == 0) {
+			if (m->ln == m->bl[i])
+				return(i);
+			r = -2;
+		}
+	return(r);
+}
+/*
+ * a boundary of the multipart at "level", closing it if "close". the
+ * multiparts inside it end here too, closed or not.
+ */
+static int
+delimiter( ENCTX *g, int level, int close )
+{
+	struct mime *m = &g->msg;
+
+	m->held = 0;
+	if (m->state == M_BODY && m->body == MT_TEXT) {
+		m->done = 1;
+		return(decodeEnd(g));
+	}
+	if (close) {
+		m->nb = level;
+		m->state = M_BODY;
+		m->body = MT_SKIP;
+		return(0);
+	}
+	m->nb = level + 1;
+	headStart(m, m->digest[level] ? MT_MESSAGE : MT_SKIP);
+	return(0);
+}
+/*
+ * start on the header fields of an entity, whose type is "type" unless
+ * they say otherwise
+ */
+static void
+headStart( struct mime *m, int type )
+{
+	m->state = M_HEAD;
+	m->hn = 0;
+	m->hend = 0;
+	m->hline = 0;
+	m->type = type;
+	m->enc = TE_NONE;
+	m->boundary[0] = 0;
+	m->charset[0] = 0;
+	m->isDigest = 0;
+}
+/*
+ * a complete header field. only two of them matter.
+ */
+static void
+field( struct mime *m )
+{
+	char name[32], v[32];
+	const char *s;
+
+	m->hdr[m->hn] = 0;
+	s = token(m->hdr, name, sizeof(name));
+	s = skipSpace(s);
+	if (*s++ != ':')
+		return;
+	if (strcmp(name, "content-type") == 0)
+		contentType(m, s);
+	else if (strcmp(name, "content-transfer-encoding") == 0) {
+		token(skipSpace(s), v, sizeof(v));
+		if (strcmp(v, "quoted-printable") == 0)
+			m->enc = TE_QP;
+		else if (strcmp(v, "base64") == 0)
+			m->enc = TE_B64;
+		else
+			m->enc = TE_NONE;
+	}
+}
+/*
+ * the value of a Content-Type field: the type, and the boundary and
+ * charset parameters
+ */
+static void
+contentType( struct mime *m, const char *s )
+{
+	char type[32], sub[32], name[32], v[MIMEBND + 1];
+	size_t n;
+
+	s = token(skipSpace(s), type, sizeof(type));
+	s = skipSpace(s);
+	if (*s++ != '/')
+		return;
+	s = token(skipSpace(s), sub, sizeof(sub));
+	if (strcmp(type, "multipart") == 0) {
+		m->type = MT_MULTI;
+		m->isDigest = strcmp(sub, "digest") == 0;
+	}
+	else if (strcmp(type, "message") == 0 && strcmp(sub, "rfc822") == 0)
+		m->type = MT_MESSAGE;
+	else if (strcmp(type, "text") == 0 && strcmp(sub, "enriched") == 0) {
+		m->type = MT_TEXT;
+		m->dialect = EN_ENRICHED;
+	}
+	else if (strcmp(type, "text") == 0 && strcmp(sub, "richtext") == 0) {
+		m->type = MT_TEXT;
+		m->dialect = EN_RICHTEXT;
+	}
+	else
+		m->type = MT_SKIP;
+
+	/*
+	 * the parameters: ; name = value, where the value is a token or
+	 * a quoted string. the names are in lower case, the values as
+	 * they are.
+	 */
+	for (;;) {
+		s = skipSpace(s);
+		if (*s++ != ';')
+			return;
+		s = token(skipSpace(s), name, sizeof(name));
+		s = skipSpace(s);
+		if (*s++ != '=')
+			return;
+		s = skipSpace(s);
+		n = 0;
+		if (*s == '"') {
+			for (s++; *s && *s != '"'; s++) {
+				if (*s == '\\' && s[1])
+					s++;
+				if (n < sizeof(v) - 1)
+					v[n++] = *s;
+			}
+			if (*s == '"')
+				s++;
+		}
+		else
+			for ( ; *s > ' ' && *s != ';' && *s != '(' &&
+			     *s != '"'; s++)
+				if (n < sizeof(v) - 1)
+					v[n++] = *s;
+		v[n] = 0;
+		if (strcmp(name, "boundary") == 0 && n <= MIMEBND - 2)
+			strcpy(m->boundary, v);
+		else if (strcmp(name, "charset") == 0 && n < sizeof(m->charset))
+			strcpy(m->charset, v);
+	}
+}
+/*
+ * copy a token, in lower case, into "t" (of size "n"). returns the rest
+ * of the string.
+ */
+static const char *
+token( const char *s, char *t, size_t n )
+{
+	size_t i = 0;
+
+	for ( ; *s > ' ' && *s < 0x7f && strchr("()<>@,;:\\\"/[]?=", *s) == NULL;
+	     s++)
+		if (i < n - 1)
+			t[i++] = (char)(*s >= 'A' && *s <= 'Z' ?
+					*s - 'A' + 'a' : *s);
+	t[i] = 0;
+	return(s);
+}
+/*
+ * skip white space and comments, "(...)", which may nest
+ */
+static const char *
+skipSpace( const char *s )
+{
+	int depth = 0;
+
+	for ( ; *s; s++)
+		if (*s == '(')
+			depth++;
+		else if (*s == ')' && depth > 0)
+			depth--;
+		else if (*s == '\\' && depth > 0 && s[1])
+			s++;
+		else if (depth == 0 && *s != ' ' && *s != '\t')
+			break;
+	return(s);
+}
+/*
+ * the end of an entity's header fields. a multipart opens a level (its
+ * preamble is skipped), a message/rfc822 goes on to its own header
+ * fields, and the part wanted is converted in its dialect.
+ */
+static void
+bodyStart( ENCTX *g )
+{
+	struct mime *m = &g->msg;
+	struct enOptions o;
+
+	m->state = M_BODY;
+	m->body = MT_SKIP;
+	m->held = 0;
+	switch (m->type) {
+	case MT_MULTI:
+		if (m->boundary[0] == 0 || m->nb >= MIMEDEPTH)
+			break;
+		m->bnd[m->nb][0] = '-';
+		m->bnd[m->nb][1] = '-';
+		strcpy(m->bnd[m->nb] + 2, m->boundary);
+		m->bl[m->nb] = strlen(m->bnd[m->nb]);
+		m->digest[m->nb] = m->isDigest;
+		m->nb++;
+		break;
+	case MT_MESSAGE:
+		if (m->enc == TE_NONE)
+			headStart(m, MT_SKIP);
+		break;
+	case MT_TEXT:
+		m->body = MT_TEXT;
+		m->found = 1;
+		m->qs = 0;
+		m->qn = 0;
+		m->q = 0;
+		m->cr = 0;
+		g->dialect = m->dialect;
+		g->feed = m->dialect == EN_RICHTEXT ? rtFeed : etFeed;
+		g->flush = m->dialect == EN_RICHTEXT ? rtFlush : etFlush;
+		o.charset = g->charset;
+		if (m->charset[0] && enCharset(m->charset, &o) == 0)
+			g->charset = o.charset;
+		break;
+	}
+}
+/*
+ * decode some of the part, and pass it on
+ */
+static int
+decode( ENCTX *g, const char *s, size_t n )
+{
+	struct mime *m = &g->msg;
+	char tmp[MIMEBUF];
+	const char *end = s + n;
+	size_t k = 0;
+	int c, h;
+
+	if (m->enc == TE_NONE)
+		return(pass(g, s, n));
+	while (s < end) {
+		if (k > sizeof(tmp) - 4) {
+			if (pass(g, tmp, k) != 0)
+				return(-1);
+			k = 0;
+		}
+		c = (unsigned char) *s++;
+		if (m->enc == TE_B64) {
+			/*
+			 * four characters make three bytes. "=" ends the
+			 * data early, and anything else is left out.
+			 */
+			if (c == '=') {
+				if (m->qn == 2)
+					tmp[k++] = (char)(m->q >> 4);
+				else if (m->qn == 3) {
+					tmp[k++] = (char)(m->q >> 10);
+					tmp[k++] = (char)(m->q >> 2);
+				}
+				m->qn = 0;
+				m->q = 0;
+				continue;
+			}
+			h = c >= 'A' && c <= 'Z' ? c - 'A' :
+			    c >= 'a' && c <= 'z' ? c - 'a' + 26 :
+			    c >= '0' && c <= '9' ? c - '0' + 52 :
+			    c == '+' ? 62 : c == '/' ? 63 : -1;
+			if (h < 0)
+				continue;
+			m->q = (m->q << 6 | (unsigned long) h) & 0xffffff;
+			if (++m->qn == 4) {
+				tmp[k++] = (char)(m->q >> 16);
+				tmp[k++] = (char)(m->q >> 8);
+				tmp[k++] = (char) m->q;
+				m->qn = 0;
+			}
+			continue;
+		}
+
+		/*
+		 * quoted-printable: "=" and two hex digits is a byte, and
+		 * "=" at the end of a line (after any white space) joins
+		 * it to the next. an "=" which is neither is kept.
+		 */
+		h = c >= '0' && c <= '9' ? c - '0' :
+		    c >= 'A' && c <= 'F' ? c - 'A' + 10 :
+		    c >= 'a' && c <= 'f' ? c - 'a' + 10 : -1;
+		switch (m->qs) {
+		case 0:
+			if (c == '=')
+				m->qs = 1;
+			else
+				tmp[k++] = (char) c;
+			break;
+		case 1:
+			if (h >= 0) {
+				m->qc = c;
+				m->qh = h;
+				m->qs = 2;
+			}
+			else if (c == '\n')
+				m->qs = 0;
+			else if (c == '\r' || c == ' ' || c == '\t')
+				m->qs = 3;
+			else {
+				tmp[k++] = '=';
+				m->qs = 0;
+				s--;
+			}
+			break;
+		case 2:
+			if (h >= 0) {
+				tmp[k++] = (char)(m->qh << 4 | h);
+				m->qs = 0;
+			}
+			else {
+				tmp[k++] = '=';
+				tmp[k++] = (char) m->qc;
+				m->qs = 0;
+				s--;
+			}
+			break;
+		case 3:
+			if (c == '\n')
+				m->qs = 0;
+			else if (c != '\r' && c != ' ' && c != '\t') {
+				tmp[k++] = '=';
+				m->qs = 0;
+				s--;
+			}
+			break;
+		}
+	}
+	return(k > 0 ? pass(g, tmp, k) : 0);
+}
+/*
+ * the end of the part: a quoted-printable "=" left over. a CR held back
+ * was the boundary's.
+ */
+static int
+decodeEnd( ENCTX *g )
+{
+	struct mime *m = &g->msg;
+	char tmp[2];
+	size_t k = 0;
+
+	if (m->enc == TE_QP && m->qs != 0) {
+		tmp[k++] = '=';
+		if (m->qs == 2)
+			tmp[k++] = (char) m->qc;
+	}
+	m->qs = 0;
+	if (k > 0 && pass(g, tmp, k) != 0)
+		return(-1);
+	m->cr = 0;
+	return(0);
+}
+/*
+ * pass decoded input on, with its line breaks, CR LF in the canonical
+ * form of text, as LF alone. the converters ignore a CR, but it comes
+ * between two newlines which make a paragraph break in text/enriched.
+ */
+static int
+pass( ENCTX *g, const char *s, size_t n )
+{
+	struct mime *m = &g->msg;
+	const char *end = s + n, *r;
+
+	if (m->cr && n > 0) {
+		m->cr = 0;
+		if (*s != '\n' && next(g, "\r", 1) != 0)
+			return(-1);
+	}
+	while ((r = memchr(s, '\r', (size_t)(end - s))) != NULL) {
+		if (r + 1 == end) {
+			m->cr = 1;
+			return(next(g, s, (size_t)(r - s)));
+		}
+		if (next(g, s, (size_t)(r - s) + (r[1] != '\n')) != 0)
+			return(-1);
+		s = r + 1;
+	}
+	return(next(g, s, (size_t)(end - s)));
+}
+/*
+ * and on to the character set conversion, or straight to the converter
+ */
+static int
+next( ENCTX *g, const char *s, size_t n )
+{
+	if (n == 0)
+		return(0);
+	return(g->charset ? csFeed(g, s, n) : (*g->feed)(g, s, n));
+}
@@ -0,0 +1,463 @@
+/*
+ * Name: output.c
+ *
+ * Function: buffered output for the rt2ps and et2ps filters and libenriched.
+ *	See output.h for a description.
+ */
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "output.h"
+
+/*
+ * initialize an output buffer which will be passed to "sink"
+ */
+void
+outInit( struct output *o, outSink sink, void *arg )
+{
+	o->sink = sink;
+	o->arg = arg;
+	o->n = 0;
+	o->done = 0;
+}
+/*
+ * write the buffer contents, if any
+ */
+void
+outFlush( struct output *o )
+{
+	if (o->n > 0) {
+		(*o->sink)(o->arg, o->buf, o->n);
+		o->done += o->n;
+		o->n = 0;
+	}
+}
+/*
+ * append "len" bytes. a block which is at least as big as the buffer
+ * itself, e.g. the PostScript prolog, is passed straight through
+ * rather than being copied.
+ */
+void
+outWrite( struct output *o, const char *s, size_t len )
+{
+	if (len <= OUTBUF - o->n) {
+		memcpy(o->buf + o->n, s, len);
+		o->n += len;
+		return;
+	}
+	outFlush(o);
+	if (len >= OUTBUF) {
+		(*o->sink)(o->arg, s, len);
+		o->done += len;
+	}
+	else {
+		memcpy(o->buf, s, len);
+		o->n = len;
+	}
+}
+/*
+ * append a null terminated string
+ */
+void
+outStr( struct output *o, const char *s )
+{
+	outWrite(o, s, strlen(s));
+}
+/*
+ * append the text of a PostScript string, with a backslash in front of
+ * the characters which are special in one, \, ( and ). the text is
+ * written in pieces, split before each of them, rather than copied.
+ */
+void
+outEsc( struct output *o, const char *s, size_t len )
+{
+	const char *end = s + len;
+	const char *q;
+
+	for (q = s; q < end; q++)
+		if (*q == '\\' || *q == '(' || *q == ')') {
+			outWrite(o, s, (size_t)(q - s));
+			outChar(o, '\\');
+			s = q;
+		}
+	outWrite(o, s, (size_t)(end - s));
+}
+/*
+ * append an integer in decimal, the same as printf("%i")
+ */
+void
+outInt( struct output *o, int i )
+{
+	char tmp[16];
+	char *p = &tmp[sizeof(tmp)];
+	unsigned int u = (i < 0) ? -(unsigned int)i : (unsigned int)i;
+
+	do {
+		*--p = (char)('0' + u % 10);
+		u /= 10;
+	} while (u != 0);
+	if (i < 0)
+		*--p = '-';
+	outWrite(o, p, (size_t)(&tmp[sizeof(tmp)] - p));
+}
+/*
+ * append a byte count or offset in decimal, the same as printf("%lu")
+ */
+void
+outSize( struct output *o, size_t u )
+{
+	char tmp[24];
+	char *p = &tmp[sizeof(tmp)];
+
+	do {
+		*--p = (char)('0' + u % 10);
+		u /= 10;
+	} while (u != 0);
+	outWrite(o, p, (size_t)(&tmp[sizeof(tmp)] - p));
+}
+/*
+ * append a real number, rounded to 3 decimal places, without trailing
+ * zeros. PostScript accepts it either way, but most coordinates are whole
+ * numbers.
+ */
+void
+outReal( struct output *o, double d )
+{
+	long v = (long)((d < 0) ? d * 1000 - 0.5 : d * 1000 + 0.5);
+	unsigned long u = (v < 0) ? -(unsigned long)v : (unsigned long)v;
+	char tmp[32];
+	char *p = &tmp[sizeof(tmp)];
+	int i;
+
+	for (i = 0; i < 3 && u % 10 == 0; i++)
+		u /= 10;
+	for ( ; i < 3; i++) {
+		*--p = (char)('0' + u % 10);
+		u /= 10;
+		if (i == 2)
+			*--p = '.';
+	}
+	do {
+		*--p = (char)('0' + u % 10);
+		u /= 10;
+	} while (u != 0);
+	if (v < 0)
+		*--p = '-';
+	outWrite(o, p, (size_t)(&tmp[sizeof(tmp)] - p));
+}
+/*
+ * a sink which writes to the file descriptor pointed to by "arg", coping
+ * with short writes and interrupted system calls. like stdio, a write
+ * error (other than being interrupted) just causes the rest of the block
+ * to be discarded.
+ */
+void
+outFd( void *arg, const char *s, size_t len )
+{
+	int fd = *(int *)arg;
+	ssize_t n;
+
+	while (len > 0) {
+		n = write(fd, s, len);
+		if (n < 0) {
+			if (errno == EINTR)
+				continue;
+			return;
+		}
+		s += n;
+		len -= (size_t) n;
+	}
+}
+/*
+ * a sink which keeps everything passed to it in the spool pointed to by
+ * "arg", which starts out zeroed
+ */
+void
+spoolSink( void *arg, const char *s, size_t len )
+{
+	struct spool *sp = (struct spool *) arg;
+	size_t max;
+	char *p;
+
+	if (sp->error)
+		return;
+	if (sp->fp == NULL && len <= SPOOLMEM - sp->n) {
+		if (sp->n + len > sp->max) {
+			for (max = sp->max ? sp->max : OUTBUF; max < sp->n + len; )
+				max *= 2;
+			if (max > SPOOLMEM)
+				max = SPOOLMEM;
+			if ((p = realloc(sp->buf, max)) != NULL) {
+				sp->buf = p;
+				sp->max = max;
+			}
+		}
+		if (sp->n + len <= sp->max) {
+			memcpy(sp->buf + sp->n, s, len);
+			sp->n += len;
+			return;
+		}
+	}
+	if (sp->fp == NULL && (sp->fp = tmpfile()) == NULL) {
+		sp->error = 1;
+		return;
+	}
+	if (fwrite(s, 1, len, sp->fp) != len)
+		sp->error = 1;
+}
+/*
+ * pass what's been kept in the spool on to the output buffer "o"
+ *
+ * returns 0, or -1 if some of it was lost
+ */
+int
+spoolPlay( struct spool *sp, struct output *o )
+{
+	size_t n;
+
+	if (sp->n > 0)
+		outWrite(o, sp->buf, sp->n);
+	if (sp->fp != NULL && !sp->error) {
+		outFlush(o);
+		rewind(sp->fp);
+		while ((n = fread(o->buf, 1, OUTBUF, sp->fp)) > 0) {
+			o->n = n;
+			outFlush(o);
+		}
+		if (ferror(sp->fp))
+			sp->error = 1;
+	}
+	return(sp->error ? -1 : 0);
+}
+/*
+ * release the memory and temporary file of a spool, leaving it empty
+ */
+void
+spoolFree( struct spool *sp )
+{
+	free(sp->buf);
+	if (sp->fp != NULL)
+		fclose(sp->fp);
+	memset(sp, 0, sizeof(*sp));
+}
+/*
+ * ASCII85: the characters of one group. the lines are kept short, and
+ * none of them starts with %, which a spooler could take for a comment.
+ */
+static void
+a85Put( struct squeeze *sq, const char *s, int n )
+{
+	int i;
+
+	for (i = 0; i < n; i++) {
+		if (sq->col >= 76) {
+			outChar(&sq->out, '\n');
+			sq->col = 0;
+		}
+		if (sq->col == 0 && s[i] == '%') {
+			outChar(&sq->out, ' ');
+			sq->col++;
+		}
+		outChar(&sq->out, s[i]);
+		sq->col++;
+	}
+}
+/*
+ * ASCII85: a group of four bytes as five characters from ! to u, or z
+ * for four zeros. the last group may be short, n bytes as n + 1
+ * characters.
+ */
+static void
+a85Group( struct squeeze *sq, int n )
+{
+	unsigned long v = sq->tuple;
+	char tmp[5];
+	int i;
+
+	if (n == 4 && v == 0)
+		a85Put(sq, "z", 1);
+	else {
+		for (i = 4; i >= 0; i--) {
+			tmp[i] = (char)('!' + v % 85);
+			v /= 85;
+		}
+		a85Put(sq, tmp, n + 1);
+	}
+	sq->tuple = 0;
+	sq->nt = 0;
+}
+static void
+a85Write( struct squeeze *sq, const unsigned char *s, size_t len )
+{
+	for ( ; len > 0; s++, len--) {
+		sq->tuple |= (unsigned long) *s << (24 - 8 * sq->nt);
+		if (++sq->nt == 4)
+			a85Group(sq, 4);
+	}
+}
+/*
+ * LZW: write a code, most significant bit first. with EarlyChange 1,
+ * LZWDecode takes one more bit per code as soon as its table (which is
+ * one entry behind ours) is one short of needing it.
+ */
+static void
+lzwCode( struct squeeze *sq, int code )
+{
+	unsigned char c;
+
+	if (sq->next >= 1 << sq->width && sq->width < 12)
+		sq->width++;
+	sq->bits = sq->bits << sq->width | (unsigned long) code;
+	sq->nbits += sq->width;
+	while (sq->nbits >= 8) {
+		sq->nbits -= 8;
+		c = (unsigned char)(sq->bits >> sq->nbits);
+		a85Write(sq, &c, 1);
+	}
+	sq->bits &= (1UL << sq->nbits) - 1;
+}
+/*
+ * LZW: the clear code, and an empty table
+ */
+static void
+lzwClear( struct squeeze *sq )
+{
+	int i;
+
+	lzwCode(sq, 256);
+	sq->width = 9;
+	sq->next = 258;
+	for (i = 0; i < SQHASH; i++)
+		sq->key[i] = -1;
+}
+/*
+ * LZW: extend the string matched so far by each byte, and when that
+ * string isn't in the table, write the code of the one which is and
+ * add the new one. when the table is full, it starts again.
+ */
+static void
+lzwWrite( struct squeeze *sq, const unsigned char *s, size_t len )
+{
+	long k;
+	int h;
+
+	for ( ; len > 0; s++, len--) {
+		if (sq->prefix < 0) {
+			sq->prefix = *s;
+			continue;
+		}
+		k = (long) sq->prefix << 8 | *s;
+		for (h = (int)(k % SQHASH); sq->key[h] != -1; h = (h + 1) % SQHASH)
+			if (sq->key[h] == k)
+				break;
+		if (sq->key[h] == k) {
+			sq->prefix = sq->code[h];
+			continue;
+		}
+		lzwCode(sq, sq->prefix);
+		sq->key[h] = k;
+		sq->code[h] = (short) sq->next++;
+		sq->prefix = *s;
+		if (sq->next == 4094)
+			lzwClear(sq);
+	}
+}
+/*
+ * Flate: compress, and pass on whatever zlib has ready
+ */
+static void
+flateWrite( struct squeeze *sq, const char *s, size_t len, int flush )
+{
+	unsigned char tmp[16384];
+
+	sq->z.next_in = (Bytef *) s;
+	sq->z.avail_in = (uInt) len;
+	do {
+		sq->z.next_out = tmp;
+		sq->z.avail_out = sizeof(tmp);
+		if (deflate(&sq->z, flush) == Z_STREAM_ERROR) {
+			sq->error = 1;
+			return;
+		}
+		a85Write(sq, tmp, sizeof(tmp) - sq->z.avail_out);
+	} while (sq->z.avail_out == 0);
+}
+/*
+ * start a compressed stream, method SQ_LZW or SQ_FLATE, whose text will
+ * be passed to "sink"
+ *
+ * returns 0, or -1 if there's no memory
+ */
+int
+squeezeInit( struct squeeze *sq, int method, outSink sink, void *arg )
+{
+	outInit(&sq->out, sink, arg);
+	sq->method = method;
+	sq->error = 0;
+	sq->tuple = 0;
+	sq->nt = 0;
+	sq->col = 0;
+	sq->bits = 0;
+	sq->nbits = 0;
+	sq->prefix = -1;
+	memset(&sq->z, 0, sizeof(sq->z));
+	if (method == SQ_FLATE)
+		return(deflateInit(&sq->z, Z_DEFAULT_COMPRESSION) == Z_OK ? 0 : -1);
+	sq->width = 9;
+	sq->next = 258;
+	lzwClear(sq);
+	return(0);
+}
+/*
+ * a sink which compresses everything passed to it into the stream
+ * pointed to by "arg"
+ */
+void
+squeezeSink( void *arg, const char *s, size_t len )
+{
+	struct squeeze *sq = (struct squeeze *) arg;
+
+	if (sq->method == SQ_FLATE)
+		flateWrite(sq, s, len, Z_NO_FLUSH);
+	else
+		lzwWrite(sq, (const unsigned char *) s, len);
+}
+/*
+ * end the stream: the rest of the compressed data, the ASCII85 end of
+ * data marker, and a newline, all passed on to the sink
+ */
+void
+squeezeEnd( struct squeeze *sq )
+{
+	unsigned char c;
+
+	if (sq->method == SQ_FLATE)
+		flateWrite(sq, NULL, 0, Z_FINISH);
+	else {
+		if (sq->prefix >= 0) {
+			lzwCode(sq, sq->prefix);
+			sq->next++;
+			sq->prefix = -1;
+		}
+		lzwCode(sq, 257);
+		if (sq->nbits > 0) {
+			c = (unsigned char)(sq->bits << (8 - sq->nbits));
+			a85Write(sq, &c, 1);
+			sq->nbits = 0;
+		}
+	}
+	if (sq->nt > 0)
+		a85Group(sq, sq->nt);
+	outLit(&sq->out, "~>\n");
+	outFlush(&sq->out);
+}
+/*
+ * release what zlib allocated for a stream
+ */
+void
+squeezeFree( struct squeeze *sq )
+{
+	if (sq->method == SQ_FLATE)
+		(void) deflateEnd(&sq->z);
+}
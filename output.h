@@ -0,0 +1,113 @@
+/*
+ * Name: output.h
+ *
+ * Function: buffered output for the rt2ps and et2ps filters and libenriched.
+ *
+ *	The filters write a few short strings and integers for every
+ *	token of input. Rather than paying for printf() format parsing and
+ *	stdio locking on each one, the PostScript is appended to a large
+ *	buffer with hand-written string and integer appenders, and the
+ *	buffer is handed to a sink, e.g. one write(), when it fills up.
+ */
+#ifndef OUTPUT_H
+#define OUTPUT_H
+
+#include <stddef.h>
+#include <stdio.h>
+#include <zlib.h>
+
+/* size of the output buffer */
+#define OUTBUF 65536
+
+/*
+ * a sink is called with the buffer contents each time it is flushed
+ */
+typedef void (*outSink)( void *, const char *, size_t );
+
+struct output {
+	outSink sink;		/* where the buffer goes on flush */
+	void *arg;		/* first argument to the sink */
+	size_t n;		/* number of bytes in the buffer */
+	size_t done;		/* number of bytes passed to the sink */
+	char buf[OUTBUF];	/* the buffer */
+};
+
+/*
+ * a sink which keeps the output, to be passed on later: in memory up to
+ * SPOOLMEM bytes, and the rest in a temporary file
+ */
+#define SPOOLMEM (1024 * 1024)
+
+struct spool {
+	char *buf;		/* the output kept in memory */
+	size_t n;		/* number of bytes in buf */
+	size_t max;		/* room in buf */
+	FILE *fp;		/* the rest of it, or NULL */
+	int error;		/* flag: out of memory or file space */
+};
+
+/*
+ * a sink which compresses what's passed to it, LZW as the LZWDecode
+ * filter of PostScript Level 2 expects or Flate (zlib) for FlateDecode
+ * in Level 3, and passes it on as ASCII85 text, for the ASCII85Decode
+ * filter, through its own output buffer. only the LZW table, or zlib's
+ * window, is kept, however long the stream.
+ */
+#define SQ_LZW 1
+#define SQ_FLATE 2
+#define SQHASH 5003		/* LZW hash table size, a prime over 4096 */
+
+struct squeeze {
+	struct output out;	/* the ASCII85 text */
+	int method;		/* SQ_LZW or SQ_FLATE */
+	int error;		/* flag: zlib failed */
+	unsigned long tuple;	/* ASCII85: bytes of the group so far */
+	int nt;			/* and how many */
+	int col;		/* column of the ASCII85 line */
+	unsigned long bits;	/* LZW: bits not yet written */
+	int nbits;		/* and how many */
+	int width;		/* bits per code, 9 to 12 */
+	int next;		/* next code to be assigned */
+	int prefix;		/* code of the string matched so far, or -1 */
+	long key[SQHASH];	/* prefix << 8 | byte, or -1 for empty */
+	short code[SQHASH];	/* the code for key */
+	z_stream z;		/* Flate */
+};
+
+/*
+ * append a single character
+ */
+#define outChar(o, c)	do { \
+				if ((o)->n == OUTBUF) \
+					outFlush(o); \
+				(o)->buf[(o)->n++] = (char)(c); \
+			} while (0)
+
+/*
+ * the offset in the output of the next byte appended
+ */
+#define outPos(o)	((o)->done + (o)->n)
+
+/*
+ * append a string literal, without having to count its length at run time
+ */
+#define outLit(o, s)	outWrite(o, s, sizeof(s) - 1)
+
+void outInit( struct output *, outSink, void * );
+void outFlush( struct output * );
+void outWrite( struct output *, const char *, size_t );
+void outStr( struct output *, const char * );
+void outEsc( struct output *, const char *, size_t );
+void outInt( struct output *, int );
+void outSize( struct output *, size_t );
+void outReal( struct output *, double );
+void outFd( void *, const char *, size_t );
+void spoolSink( void *, const char *, size_t );
+int  spoolPlay( struct spool *, struct output * );
+void spoolFree( struct spool * );
+int  squeezeInit( struct squeeze *, int, outSink, void * );
+void squeezeSink( void *, const char *, size_t );
+void squeezeEnd( struct squeeze * );
+void squeezeFree( struct squeeze * );
+
+#endif /* OUTPUT_H */
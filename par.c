@@ -0,0 +1,445 @@
+/*
+ * Name: par.c
+ *
+ * Function: libenriched parallel conversion of a document in memory,
+ *	enParallel(), the -j flag of rt2ps and et2ps on standard input.
+ *
+ *	The converter walks the input a byte at a time, so on its own a
+ *	long document converts on one core. Here the input is cut into
+ *	chunks where the converter's state is simple: after a run of two
+ *	or more newlines (a line break) in text/enriched, and after <nl>
+ *	in text/richtext. There nothing is half done: no token or keyword
+ *	is being collected, no lookahead is pending and no run of words is
+ *	open. What carries over is the formatting in effect: the font
+ *	attributes and size, underlining, justification and its stack,
+ *	<comment> or <param>, the main font family, and with -c the font
+ *	last sent.
+ *
+ *	Worker threads convert the chunks, each on a copy of the context
+ *	and into a buffer of its own, on the guess that the formatting in
+ *	effect at the start of the chunk is what it was at the start of the
+ *	input, which in long documents of the log or listing kind it
+ *	nearly always is. The chunks are then stitched together in order.
+ *	If the state the document is in after the chunk before is the one
+ *	the chunk was converted from, its output is passed on and the
+ *	state it ended in taken over; if not, the guess was wrong, and the
+ *	chunk is converted again, from the right state, as enFeed() would
+ *	do it. Either way the output is the same, byte for byte, as from
+ *	converting the input in one piece. A worker which would have
+ *	printed a warning or hit an error gives up, and the chunk is
+ *	converted again too, so the messages come out once, in order.
+ *
+ *	The stitching thread converts the first chunk, and any other no
+ *	worker has started on, itself. Workers stay at most two chunks
+ *	each ahead of it, so only that much output is held in memory.
+ *
+ *	The host layout (-l, and so -g, -r and -P) has the position on the
+ *	page as its state, which is never the same twice, so it isn't done
+ *	in parallel; nor is a MIME message. See enParallel().
+ */
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include "enpriv.h"
+
+#define PARCHUNK (1024 * 1024)	/* smallest chunk worth a thread */
+
+/* where a chunk is, state */
+#define C_WAIT 0		/* not started */
+#define C_BUSY 1		/* being converted by a worker */
+#define C_DONE 2		/* converted by a worker */
+
+/*
+ * a chunk of the input
+ */
+struct chunk {
+	const char *s;		/* its input */
+	size_t n;		/* and length */
+	int state;		/* C_* */
+	ENCTX *w;		/* the context a worker converted it in */
+	char *buf;		/* the output */
+	size_t len;		/* bytes in buf */
+	size_t max;		/* room in buf */
+	int nomem;		/* flag: some of the output was lost */
+};
+
+/*
+ * a document being converted in parallel
+ */
+struct par {
+	ENCTX *g;		/* its context */
+	ENCTX *guess;		/* the state the chunks are converted from */
+	struct chunk *ch;	/* the chunks */
+	int n;			/* how many */
+	int next;		/* the next one to be started */
+	int stitched;		/* how many have been stitched */
+	int window;		/* workers stay this many chunks ahead */
+	int stop;		/* flag: the conversion has failed */
+	pthread_mutex_t lock;
+	pthread_cond_t cv;	/* a chunk done, or stitched */
+};
+
+static const char *seam( const ENCTX *, const char *, const char * );
+static void *work( void * );
+static void  convert( struct par *, struct chunk * );
+static void  chunkSink( void *, const char *, size_t );
+static int   stitch( struct par *, struct chunk * );
+static int   serial( ENCTX *, const char *, size_t );
+static int   sameState( const ENCTX *, const ENCTX * );
+static void  takeState( ENCTX *, ENCTX * );
+static void  addStats( struct enStats *, const struct enStats * );
+
+/*
+ * convert "len" bytes at "s" on up to "jobs" threads
+ */
+int
+parFeed( ENCTX *g, const char *s, size_t len, int jobs )
+{
+	struct par p;
+	pthread_t *t = NULL;
+	const char *q, *end = s + len;
+	size_t size;
+	int started = 0;
+	int i, k;
+	int rc = 0;
+
+	if (jobs < 2 || len < 2 * PARCHUNK)
+		return(serial(g, s, len));
+
+	/*
+	 * cut the input into chunks, four for each thread
+	 */
+	size = len / ((size_t) jobs * 4);
+	if (size < PARCHUNK)
+		size = PARCHUNK;
+	memset(&p, 0, sizeof(p));
+	if ((p.ch = calloc(len / size + 1, sizeof(*p.ch))) == NULL)
+		return(serial(g, s, len));
+	for (p.n = 0; s < end; p.n++, s = q) {
+		q = (size_t)(end - s) <= size ? end : seam(g, s + size, end);
+		p.ch[p.n].s = s;
+		p.ch[p.n].n = (size_t)(q - s);
+	}
+	if (p.n < 2 || (p.guess = malloc(sizeof(*p.guess))) == NULL ||
+	    (t = calloc(jobs, sizeof(*t))) == NULL) {
+		for (k = 0, rc = 0; k < p.n && rc == 0; k++)
+			rc = serial(g, p.ch[k].s, p.ch[k].n);
+		free(p.guess);
+		free(p.ch);
+		return(rc);
+	}
+
+	/*
+	 * the guess: what the formatting is now, with nothing half done
+	 */
+	*p.guess = *g;
+	p.guess->keyword = 0;
+	p.guess->c = 0;
+	p.guess->buff = NULL;
+	p.guess->bmax = 0;
+	p.guess->space = 0;
+	p.guess->pending = PEND_NONE;
+	p.guess->atMargin = 1;
+	p.guess->csn = 0;
+	p.guess->csl = 0;
+	p.guess->run.n = 0;
+	p.guess->pm = g->mask;
+	p.guess->pfs = g->dialect == EN_RICHTEXT && g->fs < 6 ? 6 : g->fs;
+	p.guess->smask = p.guess->pm;
+	p.guess->ssize = p.guess->pfs;
+	p.guess->minimal = 0;
+	p.guess->squeeze = 0;
+	p.guess->sq = NULL;
+	p.guess->st = NULL;
+	p.guess->spec = 1;
+
+	/*
+	 * the first chunk is always converted here, so more workers than
+	 * there are chunks after it would have nothing to do
+	 */
+	if (jobs > p.n)
+		jobs = p.n;
+	p.g = g;
+	p.next = 1;
+	p.window = 2 * jobs;
+	pthread_mutex_init(&p.lock, NULL);
+	pthread_cond_init(&p.cv, NULL);
+	for (i = 0; i < jobs - 1; i++, started++)
+		if (pthread_create(&t[i], NULL, work, &p) != 0)
+			break;
+
+	/*
+	 * stitch the chunks together, converting those no worker has
+	 * started on
+	 */
+	for (k = 0; k < p.n; k++) {
+		pthread_mutex_lock(&p.lock);
+		if (k >= p.next)
+			p.next = k + 1;
+		else if (k > 0)
+			while (p.ch[k].state != C_DONE)
+				pthread_cond_wait(&p.cv, &p.lock);
+		pthread_mutex_unlock(&p.lock);
+		rc = stitch(&p, &p.ch[k]);
+		pthread_mutex_lock(&p.lock);
+		p.stitched = k + 1;
+		if (rc != 0)
+			p.stop = 1;
+		pthread_cond_broadcast(&p.cv);
+		pthread_mutex_unlock(&p.lock);
+		if (rc != 0)
+			break;
+	}
+
+	for (i = 0; i < started; i++)
+		pthread_join(t[i], NULL);
+	for ( ; k < p.n; k++) {
+		if (p.ch[k].w != NULL) {
+			free(p.ch[k].w->st);
+			free(p.ch[k].w->buff);
+		}
+		free(p.ch[k].w);
+		free(p.ch[k].buf);
+	}
+	pthread_cond_destroy(&p.cv);
+	pthread_mutex_destroy(&p.lock);
+	free(t);
+	free(p.guess);
+	free(p.ch);
+	return(rc);
+}
+/*
+ * the first place at or after "p" where the input can be cut, or "end"
+ */
+static const char *
+seam( const ENCTX *g, const char *p, const char *end )
+{
+	if (g->dialect == EN_RICHTEXT) {
+		for ( ; (p = memchr(p, '<', (size_t)(end - p))) != NULL; p++)
+			if (end - p >= 4 && (p[1] | 0x20) == 'n' &&
+			    (p[2] | 0x20) == 'l' && p[3] == '>')
+				return(p + 4);
+		return(end);
+	}
+	while ((p = memchr(p, '\n', (size_t)(end - p))) != NULL) {
+		if (++p < end && *p == '\n') {
+			while (p < end && *p == '\n')
+				p++;
+			return(p);
+		}
+	}
+	return(end);
+}
+/*
+ * a worker: convert chunks until there are no more
+ */
+static void *
+work( void *arg )
+{
+	struct par *p = arg;
+	struct chunk *c;
+
+	for (;;) {
+		pthread_mutex_lock(&p->lock);
+		while (!p->stop && p->next < p->n &&
+		       p->next - p->stitched >= p->window)
+			pthread_cond_wait(&p->cv, &p->lock);
+		if (p->stop || p->next >= p->n) {
+			pthread_mutex_unlock(&p->lock);
+			return(NULL);
+		}
+		c = &p->ch[p->next++];
+		c->state = C_BUSY;
+		pthread_mutex_unlock(&p->lock);
+
+		convert(p, c);
+
+		pthread_mutex_lock(&p->lock);
+		c->state = C_DONE;
+		pthread_cond_broadcast(&p->cv);
+		pthread_mutex_unlock(&p->lock);
+	}
+}
+/*
+ * convert a chunk from the guessed state, into its own buffer
+ */
+static void
+convert( struct par *p, struct chunk *c )
+{
+	ENCTX *w;
+
+	if ((w = malloc(sizeof(*w))) == NULL) {
+		c->nomem = 1;
+		return;
+	}
+	*w = *p->guess;
+	outInit(&w->out, chunkSink, c);
+	if (p->g->st != NULL && (w->st = calloc(1, sizeof(*w->st))) == NULL)
+		c->nomem = 1;
+	else if (serial(w, c->s, c->n) != 0)
+		w->error = 1;
+	else
+		outFlush(&w->out);
+	c->w = w;
+}
+/*
+ * keep a chunk's output
+ */
+static void
+chunkSink( void *arg, const char *s, size_t len )
+{
+	struct chunk *c = arg;
+	size_t max;
+	char *b;
+
+	if (c->nomem)
+		return;
+	if (len > c->max - c->len) {
+		for (max = c->max ? c->max : OUTBUF; max - c->len < len; max *= 2)
+			;
+		if ((b = realloc(c->buf, max)) == NULL) {
+			c->nomem = 1;
+			return;
+		}
+		c->buf = b;
+		c->max = max;
+	}
+	memcpy(c->buf + c->len, s, len);
+	c->len += len;
+}
+/*
+ * the next chunk in order: its output, if it was converted from the state
+ * the document is in, otherwise convert it now
+ */
+static int
+stitch( struct par *p, struct chunk *c )
+{
+	ENCTX *g = p->g;
+	ENCTX *w = c->w;
+	int rc = 0;
+
+	if (w != NULL && !w->error && !c->nomem && sameState(g, p->guess)) {
+		outWrite(&g->out, c->buf, c->len);
+		takeState(g, w);
+		g->uses |= w->uses;
+		if (g->st != NULL)
+			addStats(g->st, w->st);
+	}
+	else
+		rc = serial(g, c->s, c->n);
+	if (w != NULL) {
+		free(w->st);
+		free(w->buff);
+	}
+	free(w);
+	free(c->buf);
+	c->w = NULL;
+	c->buf = NULL;
+	return(rc);
+}
+/*
+ * convert some input in one piece, through the character set conversion
+ */
+static int
+serial( ENCTX *g, const char *s, size_t len )
+{
+	return(g->charset ? csFeed(g, s, len) : (*g->feed)(g, s, len));
+}
+/*
+ * is the document's state "a" the guessed state "b"? the guess has
+ * nothing half done, so neither must the document.
+ */
+static int
+sameState( const ENCTX *a, const ENCTX *b )
+{
+	if (a->keyword || a->c != 0 || a->space ||
+	    a->pending != PEND_NONE || a->csn != 0 || a->run.n != 0)
+		return(0);
+	if (a->super != b->super || a->sub != b->sub ||
+	    a->scaled != b->scaled || a->justify != b->justify ||
+	    a->justifyOff != b->justifyOff || a->jsp != b->jsp ||
+	    a->fs != b->fs || a->ffs != b->ffs ||
+	    a->atMargin != b->atMargin || a->suppress != b->suppress ||
+	    a->underline != b->underline || a->mask != b->mask ||
+	    a->times != b->times)
+		return(0);
+	if (a->jsp > 0 &&
+	    memcmp(a->jstack, b->jstack, (size_t) a->jsp * sizeof(int)) != 0)
+		return(0);
+	if (a->compact && (a->pm != b->pm || a->pfs != b->pfs))
+		return(0);
+	if (a->st != NULL && (a->smask != b->smask || a->ssize != b->ssize ||
+			      a->depth != b->depth))
+		return(0);
+	return(1);
+}
+/*
+ * the state a chunk ended in becomes the document's. the token buffers
+ * are swapped, and the document's old one goes with the chunk.
+ */
+static void
+takeState( ENCTX *g, ENCTX *w )
+{
+	char *b;
+
+	b = g->buff;
+	g->keyword = w->keyword;
+	g->c = w->c;
+	g->buff = w->buff;
+	g->bmax = w->bmax;
+	w->buff = b;
+	g->space = w->space;
+	g->super = w->super;
+	g->sub = w->sub;
+	g->scaled = w->scaled;
+	g->justify = w->justify;
+	g->justifyOff = w->justifyOff;
+	g->jsp = w->jsp;
+	memcpy(g->jstack, w->jstack, sizeof(g->jstack));
+	g->fs = w->fs;
+	g->pfs = w->pfs;
+	g->ffs = w->ffs;
+	g->atMargin = w->atMargin;
+	g->suppress = w->suppress;
+	g->underline = w->underline;
+	g->mask = w->mask;
+	g->pm = w->pm;
+	g->pending = w->pending;
+	g->csc = w->csc;
+	g->csn = w->csn;
+	memcpy(g->csb, w->csb, sizeof(g->csb));
+	g->csl = w->csl;
+	g->times = w->times;
+	g->run = w->run;
+	g->smask = w->smask;
+	g->ssize = w->ssize;
+	g->depth = w->depth;
+}
+/*
+ * add a chunk's counters to the document's
+ */
+static void
+addStats( struct enStats *st, const struct enStats *c )
+{
+	int i;
+
+	for (i = 0; i < EN_MAXACTION; i++)
+		st->token[i] += c->token[i];
+	st->s += c->s;
+	st->us += c->us;
+	st->t += c->t;
+	st->ut += c->ut;
+	for (i = 0; i < EN_MAXKEY; i++) {
+		st->keyOn[i] += c->keyOn[i];
+		st->keyOff[i] += c->keyOff[i];
+	}
+	st->unknown += c->unknown;
+	st->fonts += c->fonts;
+	st->sizes += c->sizes;
+	st->nl += c->nl;
+	st->np += c->np;
+	if (c->indent > st->indent)
+		st->indent = c->indent;
+	if (c->jstack > st->jstack)
+		st->jstack = c->jstack;
+}
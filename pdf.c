@@ -0,0 +1,447 @@
+/*
+ * Name: pdf.c
+ *
+ * Function: libenriched PDF output, the -P flag of rt2ps and et2ps.
+ *
+ *	PDF has no procedures, so there's no prolog to lay out the lines:
+ *	this mode uses the host layout (layout.c), which hands each
+ *	finished line to the same drawing operations it would write as
+ *	PostScript (moveto, show, widthshow, F2, UL, rmoveto), and they
+ *	come here instead. The text goes out in the twelve standard fonts
+ *	the prolog uses, which every PDF reader has, encoded as the prolog
+ *	reencodes them (ISOLatin1Encoding), so the widths in afm.h hold.
+ *	widthshow is the Tw word spacing operator, which pads the space
+ *	character just as widthshow does.
+ *
+ *	The file is written as it goes. The fonts, their resources and the
+ *	"3D" title of the running header (a form, as in the prolog) come
+ *	first; then, as each page is finished, its content stream,
+ *	compressed, and the page itself; and at the end the page tree, the
+ *	catalog and the cross-reference table. Only the page being drawn
+ *	is kept in memory, with the offset of each object and the number
+ *	of each page.
+ *
+ *	Object numbers:
+ *
+ *		1	catalog
+ *		2	page tree
+ *		3	resources of every page: the fonts and the form
+ *		4	the encoding of the fonts
+ *		5-16	the fonts, F0 to F11, numbered as in afm.h
+ *		17	the form for the running header
+ *		18-	each page's content stream and then the page
+ *
+ * Data Format: see engine.c.
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <zlib.h>
+#include "enpriv.h"
+
+#define PDF_CATALOG 1
+#define PDF_PAGES 2
+#define PDF_RES 3
+#define PDF_ENC 4
+#define PDF_FONT 5
+#define PDF_FORM 17
+#define PDF_FIRST 18
+
+/*
+ * the names of the fonts, as numbered in afm.h
+ */
+static const char *pdfFontName[12] = {
+	"Helvetica", "Helvetica-Bold", "Helvetica-Oblique",
+	"Helvetica-BoldOblique", "Times-Roman", "Times-Bold", "Times-Italic",
+	"Times-BoldItalic", "Courier", "Courier-Bold", "Courier-Oblique",
+	"Courier-BoldOblique"
+};
+
+/*
+ * ISOLatin1Encoding, as WinAnsiEncoding and the differences: the quotes
+ * at 39 and 96, nothing at 128-143, and the accents at 144-159
+ */
+#define PDF_ENCODING "<< /Type /Encoding /BaseEncoding /WinAnsiEncoding\n" \
+	"/Differences [39 /quoteright 96 /quoteleft\n" \
+	"128 /.notdef /.notdef /.notdef /.notdef /.notdef /.notdef\n" \
+	"/.notdef /.notdef /.notdef /.notdef /.notdef /.notdef\n" \
+	"/.notdef /.notdef /.notdef /.notdef\n" \
+	"/dotlessi /grave /acute /circumflex /tilde /macron /breve\n" \
+	"/dotaccent /dieresis /.notdef /ring /cedilla /.notdef\n" \
+	"/hungarumlaut /ogonek /caron] >>\n"
+
+static void pdfSink( void *, const char *, size_t );
+static int  pdfObj( ENCTX *, size_t );
+static void pdfStream( ENCTX *, size_t, const char *, const char *, size_t );
+static void pdfForm( ENCTX * );
+static void pdfHeader( ENCTX * );
+
+/*
+ * start the PDF file: everything the pages share
+ */
+void
+pdfOpen( ENCTX *g )
+{
+	struct pdf *p = &g->pdf;
+	struct output *o = &g->out;
+	time_t tloc;
+	char *s;
+	int i;
+
+	p->nobj = PDF_FIRST;
+	outInit(&p->page, pdfSink, g);
+	time(&tloc);
+	strcpy(p->msg, "Message converted on ");
+	strncat(p->msg, ctime(&tloc), sizeof(p->msg) - strlen(p->msg) - 1);
+	if ((s = strchr(p->msg, '\n')) != NULL)
+		*s = 0;
+
+	/*
+	 * the binary comment tells programs which guess that it's binary
+	 */
+	outLit(o, "%PDF-1.4\n%\342\343\317\323\n");
+	if (pdfObj(g, PDF_ENC) != 0)
+		return;
+	outLit(o, PDF_ENCODING "endobj\n");
+	for (i = 0; i < 12; i++) {
+		if (pdfObj(g, PDF_FONT + i) != 0)
+			return;
+		outLit(o, "<< /Type /Font /Subtype /Type1 /BaseFont /");
+		outStr(o, pdfFontName[i]);
+		outLit(o, "\n/Encoding 4 0 R >>\nendobj\n");
+	}
+	if (pdfObj(g, PDF_RES) != 0)
+		return;
+	outLit(o, "<< /ProcSet [/PDF /Text] /Font <<");
+	for (i = 0; i < 12; i++) {
+		outLit(o, " /F");
+		outInt(o, i);
+		outChar(o, ' ');
+		outInt(o, PDF_FONT + i);
+		outLit(o, " 0 R");
+	}
+
+	/*
+	 * the form is written whether there's a header or not, so that
+	 * every object in the cross-reference table is there
+	 */
+	outLit(o, " >>\n/XObject << /MF 17 0 R >> >>\nendobj\n");
+	pdfForm(g);
+}
+/*
+ * start a page, with its box and running header
+ */
+void
+pdfPageOpen( ENCTX *g )
+{
+	struct pdf *p = &g->pdf;
+
+	p->n = 0;
+	p->tw = 0;
+	if (g->box)
+		outLit(&p->page, "70 70 472 652 re S\n");
+	if (g->hdr)
+		pdfHeader(g);
+}
+/*
+ * the end of a page: its content stream, compressed, and the page
+ */
+void
+pdfPageClose( ENCTX *g )
+{
+	struct pdf *p = &g->pdf;
+	struct output *o = &g->out;
+	size_t n = p->nobj;
+	int *kid;
+	size_t max;
+
+	outFlush(&p->page);
+	if (p->nomem) {
+		enFatal(g, "Out of memory");
+		return;
+	}
+	if (p->npage == p->maxpage) {
+		max = p->maxpage ? 2 * p->maxpage : 64;
+		if ((kid = realloc(p->kid, max * sizeof(*kid))) == NULL) {
+			enFatal(g, "Out of memory");
+			return;
+		}
+		p->kid = kid;
+		p->maxpage = max;
+	}
+	pdfStream(g, n, "", p->buf, p->n);
+	if (g->error || pdfObj(g, n + 1) != 0)
+		return;
+	outLit(o, "<< /Type /Page /Parent 2 0 R /MediaBox [0 0 612 792]\n");
+	outLit(o, "/Resources 3 0 R /Contents ");
+	outSize(o, n);
+	outLit(o, " 0 R >>\nendobj\n");
+	p->kid[p->npage++] = (int)(n + 1);
+	p->nobj = n + 2;
+}
+/*
+ * the end of the file: the page tree, the catalog, the cross-reference
+ * table and the trailer
+ */
+void
+pdfFinish( ENCTX *g )
+{
+	struct pdf *p = &g->pdf;
+	struct output *o = &g->out;
+	size_t xref;
+	size_t i;
+	char tmp[24];
+
+	if (pdfObj(g, PDF_PAGES) != 0)
+		return;
+	outLit(o, "<< /Type /Pages /Count ");
+	outSize(o, p->npage);
+	outLit(o, " /Kids [");
+	for (i = 0; i < p->npage; i++) {
+		outChar(o, i % 10 ? ' ' : '\n');
+		outInt(o, p->kid[i]);
+		outLit(o, " 0 R");
+	}
+	outLit(o, "] >>\nendobj\n");
+	if (pdfObj(g, PDF_CATALOG) != 0)
+		return;
+	outLit(o, "<< /Type /Catalog /Pages 2 0 R >>\nendobj\n");
+
+	/*
+	 * each entry is exactly 20 bytes
+	 */
+	xref = outPos(o);
+	outLit(o, "xref\n0 ");
+	outSize(o, p->nobj);
+	outLit(o, "\n0000000000 65535 f \n");
+	for (i = 1; i < p->nobj; i++) {
+		sprintf(tmp, "%010lu 00000 n \n", (unsigned long) p->obj[i]);
+		outStr(o, tmp);
+	}
+	outLit(o, "trailer\n<< /Size ");
+	outSize(o, p->nobj);
+	outLit(o, " /Root 1 0 R >>\nstartxref\n");
+	outSize(o, xref);
+	outLit(o, "\n%%EOF\n");
+}
+/*
+ * free the page buffer and the tables
+ */
+void
+pdfClose( ENCTX *g )
+{
+	free(g->pdf.buf);
+	free(g->pdf.obj);
+	free(g->pdf.kid);
+}
+/*
+ * the drawing operations of the host layout. moveto and rmoveto only
+ * move the current point, which each string is shown at.
+ */
+void
+pdfMove( ENCTX *g, double x, double y )
+{
+	g->pdf.x = x;
+	g->pdf.y = y;
+}
+void
+pdfRMove( ENCTX *g, double dx, double dy )
+{
+	g->pdf.x += dx;
+	g->pdf.y += dy;
+}
+/*
+ * the font, F2
+ */
+void
+pdfFont( ENCTX *g, int font, int size )
+{
+	struct output *o = &g->pdf.page;
+
+	outLit(o, "/F");
+	outInt(o, font);
+	outChar(o, ' ');
+	outInt(o, size);
+	outLit(o, " Tf\n");
+}
+/*
+ * show a string, escaped by outEsc() as for PostScript, which is also how
+ * PDF wants it. "adj" is the padding of each space (widthshow), and "w"
+ * the length of the whole string, padding and all, which the current
+ * point moves by.
+ */
+void
+pdfText( ENCTX *g, const char *s, size_t len, double adj, double w )
+{
+	struct pdf *p = &g->pdf;
+	struct output *o = &p->page;
+
+	outLit(o, "BT ");
+	if (adj != p->tw) {
+		outReal(o, adj);
+		outLit(o, " Tw ");
+		p->tw = adj;
+	}
+	outReal(o, p->x);
+	outChar(o, ' ');
+	outReal(o, p->y);
+	outLit(o, " Td (");
+	outEsc(o, s, len);
+	outLit(o, ") Tj ET\n");
+	p->x += w;
+}
+/*
+ * underline the next "w" points, 2 points below the current point, UL
+ */
+void
+pdfLine( ENCTX *g, double w )
+{
+	struct pdf *p = &g->pdf;
+	struct output *o = &p->page;
+
+	outReal(o, p->x);
+	outChar(o, ' ');
+	outReal(o, p->y - 2);
+	outLit(o, " m ");
+	outReal(o, p->x + w);
+	outChar(o, ' ');
+	outReal(o, p->y - 2);
+	outLit(o, " l S\n");
+}
+/*
+ * output sink of the page being drawn: it collects in memory
+ */
+static void
+pdfSink( void *arg, const char *buf, size_t len )
+{
+	struct pdf *p = &((ENCTX *) arg)->pdf;
+	char *b;
+	size_t max;
+
+	if (p->nomem)
+		return;
+	if (p->max - p->n < len) {
+		for (max = p->max ? p->max : 65536; max - p->n < len; max *= 2)
+			;
+		if ((b = realloc(p->buf, max)) == NULL) {
+			p->nomem = 1;
+			return;
+		}
+		p->buf = b;
+		p->max = max;
+	}
+	memcpy(p->buf + p->n, buf, len);
+	p->n += len;
+}
+/*
+ * start object "n", noting where it is for the cross-reference table.
+ * returns 0, or -1 if there's no memory.
+ */
+static int
+pdfObj( ENCTX *g, size_t n )
+{
+	struct pdf *p = &g->pdf;
+	size_t *obj;
+	size_t max;
+
+	if (n >= p->maxobj) {
+		for (max = p->maxobj ? p->maxobj : 256; n >= max; max *= 2)
+			;
+		if ((obj = realloc(p->obj, max * sizeof(*obj))) == NULL) {
+			enFatal(g, "Out of memory");
+			return(-1);
+		}
+		p->obj = obj;
+		p->maxobj = max;
+	}
+	p->obj[n] = outPos(&g->out);
+	outSize(&g->out, n);
+	outLit(&g->out, " 0 obj\n");
+	return(0);
+}
+/*
+ * object "n", a content stream: "len" bytes at "s", compressed. "dict" is
+ * any more of the stream's dictionary.
+ */
+static void
+pdfStream( ENCTX *g, size_t n, const char *dict, const char *s, size_t len )
+{
+	struct output *o = &g->out;
+	uLongf zlen = compressBound((uLong) len);
+	Bytef *z;
+
+	if ((z = malloc(zlen)) == NULL) {
+		enFatal(g, "Out of memory");
+		return;
+	}
+	if (compress2(z, &zlen, (const Bytef *) s, (uLong) len,
+		      Z_DEFAULT_COMPRESSION) != Z_OK) {
+		free(z);
+		enFatal(g, "Out of memory");
+		return;
+	}
+	if (pdfObj(g, n) == 0) {
+		outLit(o, "<< ");
+		outStr(o, dict);
+		outLit(o, "/Length ");
+		outSize(o, (size_t) zlen);
+		outLit(o, " /Filter /FlateDecode >>\nstream\n");
+		outWrite(o, (const char *) z, (size_t) zlen);
+		outLit(o, "\nendstream\nendobj\n");
+	}
+	free(z);
+}
+/*
+ * the "3D" title of the running header, as the prolog's MF form draws
+ * it: "MIME" in 24 point Times-Roman, 21 times in grays from white to
+ * black, each 1 point right and .5 down from the last, and then once
+ * more filled white and outlined
+ */
+static void
+pdfForm( ENCTX *g )
+{
+	struct pdf *p = &g->pdf;
+	struct output *o = &p->page;
+	int i;
+
+	p->n = 0;
+	outLit(o, "/F4 24 Tf\n");
+	for (i = 0; i <= 20; i++) {
+		outReal(o, 1 - i * .05);
+		outLit(o, " g BT ");
+		outInt(o, i);
+		outChar(o, ' ');
+		outReal(o, -i * .5);
+		outLit(o, " Td (MIME) Tj ET\n");
+	}
+	outLit(o, "1 g 0 G .2 w 2 Tr BT 21 -10.5 Td (MIME) Tj ET\n");
+	outFlush(o);
+	if (p->nomem) {
+		enFatal(g, "Out of memory");
+		return;
+	}
+	pdfStream(g, PDF_FORM, "/Type /XObject /Subtype /Form "
+		  "/BBox [-1 -12 90 18]\n/Resources 3 0 R ", p->buf, p->n);
+}
+/*
+ * the running header, PH: the "3D" title, the date and the page number
+ */
+static void
+pdfHeader( ENCTX *g )
+{
+	struct pdf *p = &g->pdf;
+	struct output *o = &p->page;
+	char num[32];
+	double w;
+
+	outLit(o, "q 1 0 0 1 50 734 cm /MF Do Q\n/F4 12 Tf\nBT 148 724 Td (");
+	outStr(o, p->msg);
+	outLit(o, ") Tj ET\n");
+	sprintf(num, "Page %lu", (unsigned long) g->lay.pageno);
+	w = layWidth(4, 12, num, strlen(num));
+	outLit(o, "BT ");
+	outReal(o, 542 - w);
+	outLit(o, " 724 Td (");
+	outStr(o, num);
+	outLit(o, ") Tj ET\n");
+}
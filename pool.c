@@ -0,0 +1,164 @@
+/*
+ * Name: pool.c
+ *
+ * Function: a work-stealing thread pool. See pool.h for a description.
+ *
+ *	All the tasks are known before the workers start and no task
+ *	creates another, so a worker which finds every queue empty is
+ *	finished.
+ */
+#include <pthread.h>
+#include <stdlib.h>
+#include "pool.h"
+
+/*
+ * a worker's queue: task[head] to task[tail-1] are waiting
+ */
+struct deque {
+	pthread_mutex_t lock;
+	int *task;
+	int head;
+	int tail;
+};
+
+/*
+ * a worker
+ */
+struct worker {
+	pthread_t t;		/* its thread */
+	int i;			/* its index */
+	struct pool *p;		/* the pool it belongs to */
+};
+
+struct pool {
+	int n;			/* number of workers */
+	struct deque *q;	/* a queue for each worker */
+	poolTask fn;		/* the task function */
+	void *arg;		/* its first argument */
+};
+
+static int   take( struct deque * );
+static int   steal( struct deque * );
+static void *work( void * );
+
+/*
+ * run tasks 0 to ntasks-1 on "nthreads" threads, calling fn(arg, task)
+ * for each one, and wait for them all to finish.
+ *
+ * returns 0, or -1 if the threads can't be started. the tasks have all
+ * been run in that case too, by the threads which did start or just by
+ * the caller.
+ */
+int
+poolRun( int nthreads, int ntasks, poolTask fn, void *arg )
+{
+	struct pool p;
+	struct worker *w = NULL;
+	int *all;
+	int started;
+	int i, k;
+	int rc = 0;
+
+	if (nthreads > ntasks)
+		nthreads = ntasks;
+	if (nthreads < 1)
+		nthreads = 1;
+	p.n = nthreads;
+	p.fn = fn;
+	p.arg = arg;
+	if ((all = malloc((ntasks + 1) * sizeof(int))) == NULL ||
+	    (p.q = calloc(nthreads, sizeof(*p.q))) == NULL ||
+	    (w = calloc(nthreads, sizeof(*w))) == NULL) {
+		if (all != NULL)
+			free(p.q);
+		free(all);
+		for (i = 0; i < ntasks; i++)
+			(*fn)(arg, i);
+		return(-1);
+	}
+
+	/*
+	 * deal out the tasks. worker i gets tasks i, i+n, i+2n ... in a
+	 * slice of "all"
+	 */
+	for (i = k = 0; i < nthreads; i++) {
+		pthread_mutex_init(&p.q[i].lock, NULL);
+		p.q[i].task = &all[k];
+		for (p.q[i].tail = 0; i + p.q[i].tail * nthreads < ntasks; p.q[i].tail++)
+			all[k++] = i + p.q[i].tail * nthreads;
+	}
+
+	/*
+	 * the calling thread is worker 0
+	 */
+	for (started = 1; started < nthreads; started++) {
+		w[started].i = started;
+		w[started].p = &p;
+		if (pthread_create(&w[started].t, NULL, work, &w[started]) != 0) {
+			rc = -1;
+			break;
+		}
+	}
+	w[0].i = 0;
+	w[0].p = &p;
+	work(&w[0]);
+	for (i = 1; i < started; i++)
+		pthread_join(w[i].t, NULL);
+
+	for (i = 0; i < nthreads; i++)
+		pthread_mutex_destroy(&p.q[i].lock);
+	free(all);
+	free(p.q);
+	free(w);
+	return(rc);
+}
+/*
+ * a worker: run tasks from its own queue, then from the others'
+ */
+static void *
+work( void *arg )
+{
+	struct worker *w = arg;
+	struct pool *p = w->p;
+	int t;
+	int i;
+
+	for (;;) {
+		if ((t = take(&p->q[w->i])) < 0) {
+			for (i = 1; i < p->n; i++)
+				if ((t = steal(&p->q[(w->i + i) % p->n])) >= 0)
+					break;
+			if (t < 0)
+				return(NULL);
+		}
+		(*p->fn)(p->arg, t);
+	}
+}
+/*
+ * take the newest task from a worker's own queue, -1 if it's empty
+ */
+static int
+take( struct deque *q )
+{
+	int t = -1;
+
+	pthread_mutex_lock(&q->lock);
+	if (q->head < q->tail)
+		t = q->task[--q->tail];
+	pthread_mutex_unlock(&q->lock);
+	return(t);
+}
+/*
+ * steal the oldest task from another worker's queue, -1 if it's empty
+ */
+static int
+steal( struct deque *q )
+{
+	int t = -1;
+
+	pthread_mutex_lock(&q->lock);
+	if (q->head < q->tail)
+		t = q->task[q->head++];
+	pthread_mutex_unlock(&q->lock);
+	return(t);
+}
@@ -0,0 +1,24 @@
+/*
+ * Name: pool.h
+ *
+ * Function: a work-stealing thread pool, used by the rt2ps and et2ps
+ *	filters to convert many files at once.
+ *
+ *	The tasks are numbered 0 to n-1 and are dealt out round robin to
+ *	the workers, each of which keeps its share in a queue of its own.
+ *	A worker takes tasks from the back of its own queue. When its queue
+ *	is empty it steals from the front of another worker's, so a worker
+ *	which has drawn a few large files doesn't hold up the rest.
+ */
+#ifndef POOL_H
+#define POOL_H
+
+/*
+ * a task: "arg" is the argument given to poolRun(), "task" the number of
+ * the task
+ */
+typedef void (*poolTask)( void *arg, int task );
+
+int poolRun( int, int, poolTask, void * );
+
+#endif /* POOL_H */
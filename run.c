@@ -0,0 +1,121 @@
+/*
+ * Name: run.c
+ *
+ * Function: libenriched runs of words, the -w flag of rt2ps and et2ps.
+ *
+ *	Normally each word, and each group of spaces, is a token of its
+ *	own, and the prolog finds the font, measures the string and rolls
+ *	it around the operand stack once for every one of them. In this
+ *	mode the words in the same font, size and underlining are collected,
+ *	with the spaces between them, and sent as one token, a "run", which
+ *	carries its count of spaces for full justification:
+ *
+ *		[(the quick brown fox) 10 f1 12 3] C
+ *
+ *	The prolog measures and shows a run as a whole if it fits on the
+ *	line, and splits it at the right margin otherwise (RN1, RBRK), so
+ *	the layout is the same as if the tokens had been sent one by one.
+ *	For that, a run always starts and ends with a word: spaces which
+ *	aren't followed by another word of the run are sent by themselves,
+ *	as before, so that TRUNC still finds them at the end of a line.
+ *
+ * Data Format: see engine.c.
+ */
+#include <string.h>
+#include "enpriv.h"
+
+/*
+ * a token, as tokenOutput() would send to the C macro. "s" is the string,
+ * as it is in the input, "mask" the font attributes, or -1 for the
+ * "don't care" font x.
+ */
+void
+runToken( ENCTX *g, const char *s, size_t len, int size, int mask, int action )
+{
+	struct run *r = &g->run;
+
+	switch (action) {
+	/*
+	 * a word: it continues the run if there are spaces in front of
+	 * it, otherwise it starts a new one
+	 */
+	case 0:
+	case 1:
+		if (r->n > 0 && r->sp > 0 && size == r->size &&
+		    mask == r->mask && action == r->action &&
+		    len <= RUNMAX - r->n) {
+			memcpy(r->text + r->n, s, len);
+			r->n += len;
+			r->sc += (int) r->sp;
+			r->sp = 0;
+			r->words++;
+			return;
+		}
+		enEndRun(g);
+		if (mask < 0 || len > RUNMAX) {
+			enToken(g, s, len, size, mask, action);
+			return;
+		}
+		memcpy(r->text, s, len);
+		r->n = len;
+		r->size = size;
+		r->mask = mask;
+		r->action = action;
+		r->words = 1;
+		r->sc = 0;
+		r->sp = 0;
+		return;
+	/*
+	 * space(s): they're kept at the end of the run, in case another
+	 * word follows
+	 */
+	case 2:
+	case 3:
+		if (r->n > 0 && r->sp == 0 && action == r->action + 2 &&
+		    (mask < 0 || (size == r->size && mask == r->mask)) &&
+		    len <= RUNMAX - r->n) {
+			memcpy(r->text + r->n, s, len);
+			r->n += len;
+			r->sp = len;
+			r->spFont = (mask >= 0);
+			return;
+		}
+		break;
+	}
+	enEndRun(g);
+	enToken(g, s, len, size, mask, action);
+}
+/*
+ * output the run: a run token if it has more than one word, or else a
+ * string token, and then the spaces after it, if any
+ */
+void
+runEnd( ENCTX *g )
+{
+	struct run *r = &g->run;
+	size_t n = r->n - r->sp;
+
+	if (r->words > 1) {
+		g->uses |= PS_RUN | PS_MASK(r->mask, g->times);
+		if (r->action == 1)
+			g->uses |= PS_ULINE;
+		outLit(&g->out, "[(");
+		outEsc(&g->out, r->text, n);
+		outLit(&g->out, ") ");
+		outInt(&g->out, r->size);
+		outChar(&g->out, ' ');
+		outStr(&g->out, enFont[r->mask]);
+		outChar(&g->out, ' ');
+		outInt(&g->out, 12 + r->action);
+		outChar(&g->out, ' ');
+		outInt(&g->out, r->sc);
+		outLit(&g->out, "] C\n");
+		g->pm = -1;	/* as for any token with a font, see enToken() */
+	}
+	else
+		enToken(g, r->text, n, r->size, r->mask, r->action);
+	if (r->sp > 0)
+		enToken(g, r->text + n, r->sp, r->size,
+			r->spFont ? r->mask : -1, r->action + 2);
+	r->n = 0;
+}
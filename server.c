@@ -0,0 +1,688 @@
+/*
+ * Name: server.c
+ *
+ * Function: conversion daemon for the rt2ps and et2ps filters. See
+ *	server.h for a description of the protocol.
+ *
+ *	All connections are served by one thread from an epoll loop. The
+ *	body of a job is handed to libenriched as each block arrives, and
+ *	the PostScript is queued for the client as libenriched produces it.
+ *	When a client falls behind in reading its PostScript, the daemon
+ *	stops reading from it until the queue drains.
+ *
+ *	The prolog is the same for every job except for the box and font
+ *	flags, so all four variants are built once at startup. Jobs asking
+ *	for running headers get a prolog of their own, since it contains
+ *	the time of the conversion.
+ */
+#define _GNU_SOURCE		/* for accept4() */
+#include <errno.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/epoll.h>
+#include "server.h"
+
+/* size of the blocks read from a connection */
+#define RDBLOCK 65536
+
+/* stop reading from a client when this much output is waiting for it */
+#define QMAX (1024*1024)
+
+/* longest 'O' frame payload */
+#define OPTMAX 256
+
+/* number of events taken from each epoll_wait() */
+#define MAXEVENTS 64
+
+/*
+ * bytes waiting to be written
+ */
+struct queue {
+	char *buf;		/* the bytes */
+	size_t off;		/* first byte not yet written */
+	size_t len;		/* end of the bytes */
+	size_t size;		/* size of the buffer */
+};
+
+/*
+ * a client connection
+ */
+struct conn {
+	int fd;			/* the socket */
+	unsigned char head[FR_HEAD];	/* header of the current frame */
+	int nhead;		/* bytes of the header read so far */
+	unsigned long left;	/* bytes of the payload still to come */
+	char opts[OPTMAX+1];	/* payload of an 'O' frame */
+	size_t nopts;		/* bytes of it read so far */
+	struct enOptions opt;	/* options for the current job */
+	ENCTX *ctx;		/* the conversion, once the body starts */
+	int failed;		/* flag: job failed, skip to its 'E' */
+	int eof;		/* flag: nothing more will be read */
+	int dead;		/* flag: out of memory, drop the client */
+	struct queue q;		/* frames waiting to be written */
+	unsigned int events;	/* events registered with epoll */
+};
+
+/*
+ * global static variables
+ */
+static struct {
+  const char *n;	/* program name, for error messages */
+  int dialect;		/* EN_RICHTEXT or EN_ENRICHED */
+  int ep;		/* the epoll instance */
+  struct enOptions opt;	/* default options for each job */
+  struct queue pro[4];	/* prologs, indexed by box + 2*altFont */
+  int nomem;		/* flag: out of memory preparing the prologs */
+  volatile sig_atomic_t stop;	/* flag: SIGTERM or SIGINT received */
+} s;
+
+/*
+ * function prototypes
+ */
+static void stop( int );
+static int  queueAdd( struct queue *, const char *, size_t );
+static int  queueFrame( struct queue *, int, const char *, size_t );
+static void proSink( void *, const char *, size_t );
+static void connSink( void *, const char *, size_t );
+static void connAccept( int );
+static void connEvent( struct conn *, unsigned int );
+static int  connInput( struct conn *, const char *, size_t );
+static int  connWrite( struct conn * );
+static int  connUpdate( struct conn * );
+static void connClose( struct conn * );
+static int  frameStart( struct conn * );
+static int  frameEnd( struct conn * );
+static int  jobOptions( struct conn * );
+static void jobOpen( struct conn * );
+static void jobData( struct conn *, const char *, size_t );
+static void jobEnd( struct conn * );
+static void jobFail( struct conn *, const char * );
+static void jobReset( struct conn * );
+
+/*
+ * serve conversion jobs on the socket "path" until SIGTERM or SIGINT.
+ * "opt" holds the defaults for each job, "name" is the program name for
+ * error messages.
+ *
+ * returns 0 on a clean shutdown, or 1 if the daemon can't be started.
+ */
+int
+srvRun( const char *path, int dialect, const struct enOptions *opt, const char *name )
+{
+	struct sockaddr_un addr;
+	struct epoll_event ev[MAXEVENTS];
+	struct enOptions o;
+	struct sigaction sa;
+	struct stat st;
+	int lfd;
+	int i, n;
+	int rc = 0;
+
+	s.n = name;
+	s.dialect = dialect;
+	s.opt = *opt;
+
+	/*
+	 * prepare the prologs
+	 */
+	for (i = 0; i < 4; i++) {
+		o = s.opt;
+		o.box = i & 1;
+		o.altFont = i >> 1;
+		o.hdr = 0;
+		if (enProlog(&o, proSink, &s.pro[i]) != 0 || s.nomem) {
+			fprintf(stderr, "%s: out of memory\n", s.n);
+			return(1);
+		}
+	}
+
+	/*
+	 * create the socket. a socket left behind by a previous daemon
+	 * is removed, anything else by that name is left alone.
+	 */
+	if (strlen(path) >= sizeof(addr.sun_path)) {
+		fprintf(stderr, "%s: socket name too long: %s\n", s.n, path);
+		return(1);
+	}
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	strcpy(addr.sun_path, path);
+	if (lstat(path, &st) == 0 && S_ISSOCK(st.st_mode))
+		unlink(path);
+	if ((lfd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0)) < 0 ||
+	    bind(lfd, (struct sockaddr *) &addr, sizeof(addr)) != 0 ||
+	    listen(lfd, SOMAXCONN) != 0) {
+		perror(path);
+		return(1);
+	}
+	if ((s.ep = epoll_create1(EPOLL_CLOEXEC)) < 0) {
+		perror(s.n);
+		unlink(path);
+		return(1);
+	}
+	ev[0].events = EPOLLIN;
+	ev[0].data.ptr = NULL;
+	epoll_ctl(s.ep, EPOLL_CTL_ADD, lfd, &ev[0]);
+
+	/*
+	 * a client going away shows up as a write error, not a signal.
+	 * SIGTERM and SIGINT interrupt epoll_wait() and stop the daemon.
+	 */
+	signal(SIGPIPE, SIG_IGN);
+	memset(&sa, 0, sizeof(sa));
+	sa.sa_handler = stop;
+	sigemptyset(&sa.sa_mask);
+	sigaction(SIGTERM, &sa, NULL);
+	sigaction(SIGINT, &sa, NULL);
+
+	while (!s.stop) {
+		if ((n = epoll_wait(s.ep, ev, MAXEVENTS, -1)) < 0) {
+			if (errno == EINTR)
+				continue;
+			perror(s.n);
+			rc = 1;
+			break;
+		}
+		for (i = 0; i < n; i++) {
+			if (ev[i].data.ptr == NULL)
+				connAccept(lfd);
+			else
+				connEvent(ev[i].data.ptr, ev[i].events);
+		}
+	}
+	close(lfd);
+	unlink(path);
+	return(rc);
+}
+/*
+ * signal handler: stop serving
+ */
+static void
+stop( int sig )
+{
+	(void)sig;
+	s.stop = 1;
+}
+/*
+ * append "len" bytes to a queue. returns -1 if there's no memory.
+ */
+static int
+queueAdd( struct queue *q, const char *buf, size_t len )
+{
+	size_t size;
+	char *p;
+
+	if (q->off == q->len)
+		q->off = q->len = 0;
+	if (q->len + len > q->size && q->off > 0) {
+		memmove(q->buf, q->buf + q->off, q->len - q->off);
+		q->len -= q->off;
+		q->off = 0;
+	}
+	if (q->len + len > q->size) {
+		for (size = q->size ? q->size : RDBLOCK; size < q->len + len; size *= 2)
+			;
+		if ((p = realloc(q->buf, size)) == NULL)
+			return(-1);
+		q->buf = p;
+		q->size = size;
+	}
+	memcpy(q->buf + q->len, buf, len);
+	q->len += len;
+	return(0);
+}
+/*
+ * append a frame to a queue. returns -1 if there's no memory.
+ */
+static int
+queueFrame( struct queue *q, int type, const char *buf, size_t len )
+{
+	unsigned char head[FR_HEAD];
+
+	head[0] = (unsigned char) type;
+	head[1] = (unsigned char) (len >> 24);
+	head[2] = (unsigned char) (len >> 16);
+	head[3] = (unsigned char) (len >> 8);
+	head[4] = (unsigned char) len;
+	if (queueAdd(q, (char *) head, FR_HEAD) != 0 || queueAdd(q, buf, len) != 0)
+		return(-1);
+	return(0);
+}
+/*
+ * libenriched sink which collects a prolog
+ */
+static void
+proSink( void *arg, const char *buf, size_t len )
+{
+	if (queueAdd(arg, buf, len) != 0)
+		s.nomem = 1;
+}
+/*
+ * libenriched sink which sends the PostScript to a client
+ */
+static void
+connSink( void *arg, const char *buf, size_t len )
+{
+	struct conn *c = arg;
+
+	if (queueFrame(&c->q, FR_DATA, buf, len) != 0)
+		c->dead = 1;
+}
+/*
+ * accept new clients
+ */
+static void
+connAccept( int lfd )
+{
+	struct epoll_event ev;
+	struct conn *c;
+	int fd;
+
+	while ((fd = accept4(lfd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0) {
+		if ((c = calloc(1, sizeof(*c))) == NULL) {
+			close(fd);
+			continue;
+		}
+		c->fd = fd;
+		c->opt = s.opt;
+		c->events = EPOLLIN;
+		ev.events = c->events;
+		ev.data.ptr = c;
+		if (epoll_ctl(s.ep, EPOLL_CTL_ADD, fd, &ev) != 0) {
+			close(fd);
+			free(c);
+		}
+	}
+	if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+		perror(s.n);
+}
+/*
+ * something happened on a client connection: read what it sent, and
+ * write what's waiting for it
+ */
+static void
+connEvent( struct conn *c, unsigned int events )
+{
+	static char buf[RDBLOCK];
+	ssize_t n;
+
+	if (events & EPOLLERR) {
+		connClose(c);
+		return;
+	}
+	if ((events & (EPOLLIN | EPOLLHUP)) && !c->eof) {
+		n = read(c->fd, buf, sizeof(buf));
+		if (n > 0) {
+			if (connInput(c, buf, (size_t) n) != 0)
+				c->eof = 1;
+		}
+		else if (n == 0) {
+			/*
+			 * the client has stopped sending. a job it didn't
+			 * finish is dropped, the rest of the output still
+			 * goes out.
+			 */
+			c->eof = 1;
+			jobReset(c);
+		}
+		else if (errno != EAGAIN && errno != EINTR) {
+			connClose(c);
+			return;
+		}
+	}
+	if (c->dead || connWrite(c) != 0) {
+		connClose(c);
+		return;
+	}
+	connUpdate(c);
+}
+/*
+ * process bytes read from a client. returns -1 if the client has to be
+ * dropped after its output is written.
+ */
+static int
+connInput( struct conn *c, const char *p, size_t n )
+{
+	size_t k;
+
+	while (n > 0) {
+		if (c->nhead < FR_HEAD) {
+			c->head[c->nhead++] = (unsigned char) *p++;
+			n--;
+			if (c->nhead == FR_HEAD && frameStart(c) != 0)
+				return(-1);
+			continue;
+		}
+		k = (n < c->left) ? n : (size_t) c->left;
+		if (c->head[0] == FR_OPTIONS) {
+			memcpy(c->opts + c->nopts, p, k);
+			c->nopts += k;
+		}
+		else
+			jobData(c, p, k);
+		p += k;
+		n -= k;
+		c->left -= k;
+		if (c->left == 0 && frameEnd(c) != 0)
+			return(-1);
+	}
+	return(0);
+}
+/*
+ * write as much of the queue as the client will take. returns -1 if the
+ * client has gone away.
+ */
+static int
+connWrite( struct conn *c )
+{
+	struct queue *q = &c->q;
+	ssize_t n;
+
+	while (q->off < q->len) {
+		n = send(c->fd, q->buf + q->off, q->len - q->off, MSG_NOSIGNAL);
+		if (n < 0) {
+			if (errno == EINTR)
+				continue;
+			if (errno == EAGAIN || errno == EWOULDBLOCK)
+				break;
+			return(-1);
+		}
+		q->off += (size_t) n;
+	}
+	return(0);
+}
+/*
+ * tell epoll what we're waiting for on a connection, or close it if
+ * there's nothing left to do. returns 1 if the connection was closed.
+ */
+static int
+connUpdate( struct conn *c )
+{
+	struct epoll_event ev;
+	size_t waiting = c->q.len - c->q.off;
+	unsigned int events = 0;
+
+	if (c->eof && waiting == 0) {
+		connClose(c);
+		return(1);
+	}
+	if (!c->eof && waiting < QMAX)
+		events |= EPOLLIN;
+	if (waiting > 0)
+		events |= EPOLLOUT;
+	if (events != c->events) {
+		c->events = events;
+		ev.events = events;
+		ev.data.ptr = c;
+		epoll_ctl(s.ep, EPOLL_CTL_MOD, c->fd, &ev);
+	}
+	return(0);
+}
+/*
+ * drop a client
+ */
+static void
+connClose( struct conn *c )
+{
+	close(c->fd);
+	if (c->ctx != NULL)
+		enClose(c->ctx);
+	free(c->q.buf);
+	free(c);
+}
+/*
+ * a frame header has been read. returns -1 if the frame makes no sense.
+ */
+static int
+frameStart( struct conn *c )
+{
+	c->left = ((unsigned long) c->head[1] << 24) | ((unsigned long) c->head[2] << 16) |
+		  ((unsigned long) c->head[3] << 8) | (unsigned long) c->head[4];
+	switch (c->head[0]) {
+	case FR_OPTIONS:
+		if (c->left > OPTMAX) {
+			queueFrame(&c->q, FR_ERROR, "options too long", 16);
+			return(-1);
+		}
+		c->nopts = 0;
+		break;
+	case FR_DATA:
+		break;
+	case FR_END:
+		if (c->left != 0) {
+			queueFrame(&c->q, FR_ERROR, "bad end frame", 13);
+			return(-1);
+		}
+		break;
+	default:
+		queueFrame(&c->q, FR_ERROR, "bad frame type", 14);
+		return(-1);
+	}
+	if (c->left == 0)
+		return(frameEnd(c));
+	return(0);
+}
+/*
+ * the whole of a frame has been read. returns -1 if the client has to
+ * be dropped.
+ */
+static int
+frameEnd( struct conn *c )
+{
+	c->nhead = 0;
+	switch (c->head[0]) {
+	case FR_OPTIONS:
+		if (c->failed)
+			break;
+		if (c->ctx != NULL)
+			jobFail(c, "options after body");
+		else if (jobOptions(c) != 0)
+			jobFail(c, "bad options");
+		break;
+	case FR_END:
+		jobEnd(c);
+		break;
+	}
+	return(c->dead ? -1 : 0);
+}
+/*
+ * apply the flags in an 'O' frame to the job options. the flags are
+ * the ones the programs take on the command line. returns -1 if the
+ * flags are bad.
+ */
+static int
+jobOptions( struct conn *c )
+{
+	char *t;
+	char *arg;
+	int fs;
+
+	c->opts[c->nopts] = 0;
+	for (t = strtok(c->opts, " \t\n"); t != NULL; t = strtok(NULL, " \t\n")) {
+		if (*t++ != '-' || *t == 0)
+			return(-1);
+		if (strcmp(t, "-mime") == 0) {
+			c->opt.mime = 1;
+			continue;
+		}
+		for ( ; *t; t++)
+			switch (*t) {
+			case 'b':
+				c->opt.box = 1;
+				break;
+			case 'h':
+				c->opt.hdr = 1;
+				break;
+			case 'l':
+				c->opt.layout = 1;
+				break;
+			case 'w':
+				c->opt.runs = 1;
+				break;
+			case 'c':
+				c->opt.compact = 1;
+				break;
+			case 'm':
+				c->opt.minimal = 1;
+				break;
+			case 'g':
+				c->opt.pages = 1;
+				break;
+			case 'P':
+				c->opt.pdf = 1;
+				break;
+			/*
+			 * 'r' takes a page range, attached or as the next
+			 * word, as 's' does the font size
+			 */
+			case 'r':
+				if (t[1] != 0) {
+					arg = t + 1;
+					t += strlen(t) - 1;
+				}
+				else if ((arg = strtok(NULL, " \t\n")) == NULL)
+					return(-1);
+				if (enRange(arg, &c->opt) != 0)
+					return(-1);
+				break;
+			/*
+			 * 'C' takes a character set name, the same way
+			 */
+			case 'C':
+				if (t[1] != 0) {
+					arg = t + 1;
+					t += strlen(t) - 1;
+				}
+				else if ((arg = strtok(NULL, " \t\n")) == NULL)
+					return(-1);
+				if (enCharset(arg, &c->opt) != 0)
+					return(-1);
+				break;
+			case 'k':
+				if (c->opt.resident < 2)
+					c->opt.resident++;
+				break;
+			case 'z':
+				if (c->opt.squeeze < 2)
+					c->opt.squeeze++;
+				break;
+			case 'p':
+				c->opt.prolog = 0;
+				break;
+			case 't':
+				c->opt.altFont = 1;
+				break;
+			/*
+			 * 's' takes the font size, either attached or as
+			 * the next word. as on the command line, a size
+			 * out of range is ignored.
+			 */
+			case 's':
+				if (t[1] != 0) {
+					arg = t + 1;
+					t += strlen(t) - 1;
+				}
+				else if ((arg = strtok(NULL, " \t\n")) == NULL)
+					return(-1);
+				fs = atoi(arg);
+				if (fs > 0 && fs < 36)
+					c->opt.fs = fs;
+				break;
+			default:
+				return(-1);
+			}
+	}
+	return(0);
+}
+/*
+ * start the conversion, when the first of the body arrives. unless the
+ * job needs a prolog of its own (running headers, the minimal prolog, the
+ * page structure of -g or -r, PDF, or a different -k from the daemon's),
+ * the one prepared at startup goes out.
+ */
+static void
+jobOpen( struct conn *c )
+{
+	struct enOptions o;
+	struct queue *pro;
+
+	o = c->opt;
+	if (o.prolog && !o.hdr && !o.minimal &&
+	    !o.pages && !o.from && !o.to && !o.pdf &&
+	    o.resident == s.opt.resident) {
+		pro = &s.pro[o.box + 2 * o.altFont];
+		if (queueFrame(&c->q, FR_DATA, pro->buf, pro->len) != 0)
+			c->dead = 1;
+		o.prolog = 0;
+	}
+	if ((c->ctx = enOpen(s.dialect, &o, connSink, c)) == NULL)
+		jobFail(c, "out of memory");
+}
+/*
+ * a block of the body
+ */
+static void
+jobData( struct conn *c, const char *p, size_t len )
+{
+	if (c->failed)
+		return;
+	if (c->ctx == NULL) {
+		jobOpen(c);
+		if (c->failed)
+			return;
+	}
+	if (enFeed(c->ctx, p, len) != 0)
+		jobFail(c, "conversion failed");
+}
+/*
+ * the end of a job
+ */
+static void
+jobEnd( struct conn *c )
+{
+	if (!c->failed && c->ctx == NULL)
+		jobOpen(c);
+	if (!c->failed) {
+		if (enFinish(c->ctx) != 0)
+			jobFail(c, "conversion failed");
+		else if (queueFrame(&c->q, FR_END, "", 0) != 0)
+			c->dead = 1;
+	}
+	jobReset(c);
+}
+/*
+ * the job can't be converted. the client is told right away, and the
+ * rest of the job is skipped.
+ */
+static void
+jobFail( struct conn *c, const char *msg )
+{
+	if (queueFrame(&c->q, FR_ERROR, msg, strlen(msg)) != 0)
+		c->dead = 1;
+	if (c->ctx != NULL) {
+		enClose(c->ctx);
+		c->ctx = NULL;
+	}
+	c->failed = 1;
+}
+/*
+ * get ready for the next job
+ */
+static void
+jobReset( struct conn *c )
+{
+	if (c->ctx != NULL) {
+		enClose(c->ctx);
+		c->ctx = NULL;
+	}
+	c->opt = s.opt;
+	c->failed = 0;
+	c->nhead = 0;
+}
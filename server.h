@@ -0,0 +1,56 @@
+/*
+ * Name: server.h
+ *
+ * Function: conversion daemon for the rt2ps and et2ps filters.
+ *
+ *	Rather than starting a filter process for every message, a
+ *	daemon started with "-d socket" accepts conversion jobs on a
+ *	local (AF_UNIX) stream socket. One process serves any number of
+ *	connections from a single epoll loop, and the PostScript is
+ *	streamed back as it is produced.
+ *
+ *	Both directions use the same framing. Each frame is a one byte
+ *	frame type, a four byte payload length (most significant byte
+ *	first), and the payload.
+ *
+ *	Client to daemon, one job:
+ *
+ *	'O'	optional, and only before the first 'D'. the payload is
+ *		flags as on the command line, e.g. "-b -t -s 12". the
+ *		flags are -b, -h, -l, -w, -c, -m, -k, -z, -g, -P, -r n-m,
+ *		-C charset, -t, -p, -s nn and --mime (the 'D' frames are
+ *		then the whole mail message, headers and all).
+ *		flags given to the daemon itself are the defaults for
+ *		each job.
+ *	'D'	any number of these, the payload is the next block of
+ *		the message body.
+ *	'E'	end of the job, empty payload.
+ *
+ *	Daemon to client:
+ *
+ *	'D'	the next block of PostScript.
+ *	'E'	the job is finished, empty payload.
+ *	'X'	the job failed, the payload is an error message. the rest
+ *		of the job, up to its 'E', is ignored.
+ *
+ *	Any number of jobs can be sent over one connection, one after the
+ *	other. A frame the daemon can't make sense of gets an 'X' and the
+ *	connection is closed.
+ */
+#ifndef SERVER_H
+#define SERVER_H
+
+#include "enriched.h"
+
+/* the frame types */
+#define FR_OPTIONS	'O'
+#define FR_DATA		'D'
+#define FR_END		'E'
+#define FR_ERROR	'X'
+
+/* size of a frame header */
+#define FR_HEAD 5
+
+int srvRun( const char *, int, const struct enOptions *, const char * );
+
+#endif /* SERVER_H */